@@ -0,0 +1,295 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2025, Szymon Bandel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "OscillatorDetector.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+
+/**
+ * @brief Finds channels of a detector bank that oscillate together.
+ *
+ * Every channel keeps a rolling bitset of its extremum timing: the window is
+ * split into bins of `samplesPerBin` samples and a bit is set when the channel
+ * reported an extremum in that bin. Coarse bins absorb the phase lag between
+ * coupled channels. Two channels co-oscillate when their bitsets overlap; the
+ * similarity is the Jaccard index |a & b| / |a | b|, computed with SIMD
+ * popcounts (AVX2 or SSE2).
+ *
+ * Usage:
+ *  - Call record() once per tick with the event flags of
+ *    BasicOscillatorDetectorBank::update().
+ *  - Use similarity() for a pair or findClusters() for the coupling groups.
+ */
+class OscillatorCorrelation {
+public:
+    /**
+     * @param channels Number of channels, as in the bank.
+     * @param windowBins Length of the rolling window in bins, rounded up to a multiple of 64.
+     * @param samplesPerBin Timing resolution; extrema of coupled channels must fall into the same bin.
+     */
+    explicit OscillatorCorrelation(std::size_t channels, std::size_t windowBins = 256, uint32_t samplesPerBin = 4)
+        : m_channels(channels)
+        , m_words((std::max<std::size_t>(windowBins, 1) + 63) / 64)
+        , m_samplesPerBin(std::max<uint32_t>(samplesPerBin, 1))
+        , m_bits(channels * m_words, 0) {}
+
+    /**
+     * @brief Get the number of channels.
+     */
+    std::size_t size() const {
+        return m_channels;
+    }
+
+    /**
+     * @brief Get the window length in bins.
+     */
+    std::size_t getWindowBins() const {
+        return m_words * 64;
+    }
+
+    /**
+     * @brief Record one tick of the bank.
+     * @param events OscillatorEvent flags of every channel; channels with the Extremum flag are marked.
+     */
+    void record(const uint8_t* events) {
+        if (m_binSamples == m_samplesPerBin) {
+            advanceBin();
+        }
+        ++m_binSamples;
+
+        const std::size_t word = m_bin / 64;
+        const uint64_t bit = uint64_t{ 1 } << (m_bin % 64);
+        uint64_t* bits = m_bits.data() + word;
+        for (std::size_t channel = 0; channel < m_channels; ++channel) {
+            const uint64_t marked = (events[channel] & OscillatorEvent::Extremum) != 0;
+            bits[channel * m_words] |= bit & (0 - marked);
+        }
+    }
+
+    /**
+     * @brief Clear the window of every channel.
+     */
+    void reset() {
+        std::fill(m_bits.begin(), m_bits.end(), 0);
+        m_bin = 0;
+        m_binSamples = 0;
+    }
+
+    /**
+     * @brief Get the number of bins with an extremum of one channel in the window.
+     */
+    uint32_t activity(std::size_t channel) const {
+        const uint64_t* bits = row(channel);
+        return popcountAnd(bits, bits, m_words);
+    }
+
+    /**
+     * @brief Co-oscillation of two channels.
+     * @return Jaccard index of the extremum bins in [0, 1]; 0 if neither channel had an extremum.
+     */
+    float similarity(std::size_t a, std::size_t b) const {
+        const uint32_t both = popcountAnd(row(a), row(b), m_words);
+        const uint32_t either = activity(a) + activity(b) - both;
+        return either == 0 ? 0.0f : static_cast<float>(both) / static_cast<float>(either);
+    }
+
+    /**
+     * @brief Compute the similarity of one channel to every channel.
+     * @param similarities Receives size() values.
+     */
+    void computeSimilarities(std::size_t channel, float* similarities) const {
+        for (std::size_t other = 0; other < m_channels; ++other) {
+            similarities[other] = similarity(channel, other);
+        }
+    }
+
+    /**
+     * @brief Group the channels that oscillate together.
+     *
+     * Channels are linked when their similarity reaches `minSimilarity` and a
+     * cluster is a connected group of links. Channels with fewer than
+     * `minActivity` extremum bins do not take part. Since the Jaccard index is
+     * at most min(|a|, |b|) / max(|a|, |b|), the active channels are sorted by
+     * activity and each one is only compared with channels of similar activity.
+     * @param minSimilarity Link threshold, in (0, 1].
+     * @param labels Receives size() labels: the lowest channel index of the cluster.
+     * @param minActivity Minimum number of extremum bins of a channel.
+     * @return The number of clusters with at least two channels.
+     */
+    std::size_t findClusters(float minSimilarity, uint32_t* labels, uint32_t minActivity = 2) const {
+        std::iota(labels, labels + m_channels, uint32_t{ 0 });
+
+        // Active channels, sorted by activity, with their rows copied next to each other.
+        m_order.clear();
+        m_activity.resize(m_channels);
+        for (std::size_t channel = 0; channel < m_channels; ++channel) {
+            m_activity[channel] = activity(channel);
+            if (m_activity[channel] >= std::max<uint32_t>(minActivity, 1)) {
+                m_order.push_back(static_cast<uint32_t>(channel));
+            }
+        }
+        std::sort(m_order.begin(), m_order.end(), [this](uint32_t a, uint32_t b) {
+            return m_activity[a] != m_activity[b] ? m_activity[a] < m_activity[b] : a < b;
+        });
+        m_rows.resize(m_order.size() * m_words);
+        for (std::size_t i = 0; i < m_order.size(); ++i) {
+            std::copy(row(m_order[i]), row(m_order[i]) + m_words, m_rows.data() + i * m_words);
+        }
+
+        for (std::size_t i = 0; i < m_order.size(); ++i) {
+            const uint32_t countA = m_activity[m_order[i]];
+            const uint64_t* bitsA = m_rows.data() + i * m_words;
+            for (std::size_t j = i + 1; j < m_order.size(); ++j) {
+                const uint32_t countB = m_activity[m_order[j]];
+                if (static_cast<float>(countA) < minSimilarity * static_cast<float>(countB)) {
+                    break; // all later channels are at least as active
+                }
+                const uint32_t both = popcountAnd(bitsA, m_rows.data() + j * m_words, m_words);
+                if (static_cast<float>(both) >= minSimilarity * static_cast<float>(countA + countB - both)) {
+                    join(labels, m_order[i], m_order[j]);
+                }
+            }
+        }
+
+        // Roots are the lowest channel of their cluster, so they are final before their members.
+        std::size_t clusters = 0;
+        for (std::size_t channel = 0; channel < m_channels; ++channel) {
+            const uint32_t root = find(labels, static_cast<uint32_t>(channel));
+            labels[channel] = root;
+            if (root != channel && m_activity[root] != 0) {
+                m_activity[root] = 0; // counted
+                ++clusters;
+            }
+        }
+        return clusters;
+    }
+
+    /**
+     * @brief Number of set bits in a[i] & b[i] over `words` words.
+     */
+    static uint32_t popcountAnd(const uint64_t* a, const uint64_t* b, std::size_t words) {
+        std::size_t w = 0;
+        uint64_t count = 0;
+#if defined(__AVX2__)
+        // Nibble lookup with vpshufb, byte counts summed with vpsadbw.
+        const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i low = _mm256_set1_epi8(0x0f);
+        __m256i total = _mm256_setzero_si256();
+        for (; w + 4 <= words; w += 4) {
+            const __m256i v = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + w)),
+                                               _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + w)));
+            const __m256i counts = _mm256_add_epi8(
+                _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low)),
+                _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+            total = _mm256_add_epi64(total, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+        }
+        const __m128i half = _mm_add_epi64(_mm256_castsi256_si128(total), _mm256_extracti128_si256(total, 1));
+        count = static_cast<uint64_t>(_mm_cvtsi128_si64(half)) + static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(half, half)));
+#elif defined(__SSE2__) || defined(_M_X64)
+        // Bit-sliced byte counts (no pshufb in SSE2), summed with psadbw.
+        const __m128i m1 = _mm_set1_epi8(0x55);
+        const __m128i m2 = _mm_set1_epi8(0x33);
+        const __m128i m4 = _mm_set1_epi8(0x0f);
+        __m128i total = _mm_setzero_si128();
+        for (; w + 2 <= words; w += 2) {
+            __m128i v = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + w)),
+                                      _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + w)));
+            v = _mm_sub_epi8(v, _mm_and_si128(_mm_srli_epi16(v, 1), m1));
+            v = _mm_add_epi8(_mm_and_si128(v, m2), _mm_and_si128(_mm_srli_epi16(v, 2), m2));
+            v = _mm_and_si128(_mm_add_epi8(v, _mm_srli_epi16(v, 4)), m4);
+            total = _mm_add_epi64(total, _mm_sad_epu8(v, _mm_setzero_si128()));
+        }
+        count = static_cast<uint64_t>(_mm_cvtsi128_si64(total)) + static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(total, total)));
+#endif
+        for (; w < words; ++w) {
+            count += static_cast<uint64_t>(std::popcount(a[w] & b[w]));
+        }
+        return static_cast<uint32_t>(count);
+    }
+
+private:
+    const uint64_t* row(std::size_t channel) const {
+        return m_bits.data() + channel * m_words;
+    }
+
+    // Move to the next bin and clear it; it held the oldest bin of the window.
+    void advanceBin() {
+        m_bin = (m_bin + 1) % (m_words * 64);
+        m_binSamples = 0;
+        const std::size_t word = m_bin / 64;
+        const uint64_t keep = ~(uint64_t{ 1 } << (m_bin % 64));
+        uint64_t* bits = m_bits.data() + word;
+        for (std::size_t channel = 0; channel < m_channels; ++channel) {
+            bits[channel * m_words] &= keep;
+        }
+    }
+
+    static uint32_t find(uint32_t* parents, uint32_t x) {
+        while (parents[x] != x) {
+            parents[x] = parents[parents[x]]; // path halving
+            x = parents[x];
+        }
+        return x;
+    }
+
+    static void join(uint32_t* parents, uint32_t a, uint32_t b) {
+        a = find(parents, a);
+        b = find(parents, b);
+        parents[std::max(a, b)] = std::min(a, b); // the root stays the lowest channel
+    }
+
+    std::size_t m_channels;
+    std::size_t m_words;
+    uint32_t m_samplesPerBin;
+    std::vector<uint64_t> m_bits; // channel-major, m_words per channel
+    std::size_t m_bin = 0;
+    uint32_t m_binSamples = 0;
+    mutable std::vector<uint32_t> m_order;
+    mutable std::vector<uint32_t> m_activity;
+    mutable std::vector<uint64_t> m_rows;
+};
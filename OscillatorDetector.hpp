@@ -33,8 +33,229 @@
 
 #pragma once
 
+#include <algorithm>
 #include <limits>
 #include <cstdint>
+#include <bit>
+#include <array>
+#include <memory>
+
+
+/**
+ * @brief Signal the detector tracks, see BasicOscillatorDetector::derive().
+ */
+enum class OscillatorDerivative : uint8_t {
+    Position,       // the input as is, with the caller's direction
+    Velocity,       // first difference of the input
+    Acceleration,   // second difference of the input
+};
+
+/**
+ * @brief Detection parameters shared by OscillatorDetector and detector banks.
+ */
+struct OscillatorDetectorParams {
+    uint8_t smootherThreshold{ 5 };
+    uint8_t sensitivity{ 5 };
+    uint16_t holdOff{ 0 };
+    uint16_t envelopeTolerance{ 64 };   // Q12 growth band classified as steady (64 = +-1.6% per half period)
+    uint8_t noiseGain{ 0 };             // 0: fixed smootherThreshold; otherwise adapt it to the flip rate
+    std::array<uint8_t, 4> severityLevels{ 255, 255, 255, 255 };   // extrema counts above which each level is reached, 255 = unused
+    uint16_t exitDelay{ 0 };            // quiet samples a detection outlasts its condition
+    uint16_t minHalfPeriod{ 0 };        // band gate: extrema closer than this many samples are not counted
+    uint16_t maxHalfPeriod{ 65535 };    // band gate: nor extrema further apart than this
+    OscillatorDerivative derivative{ OscillatorDerivative::Position };
+    uint8_t derivativeSmoothing{ 0 };   // EMA weight 2^-n on each derived difference, 0 = none
+
+    // Timestamped updates only, in nanoseconds.
+    int64_t smootherTime{ 5000000 };    // debounce dwell that arms the reset path (replaces smootherThreshold)
+    int64_t detectionWindow{ 0 };       // longest gap between counted extrema, 0 = unlimited
+    int64_t staleAfter{ 0 };            // a longer gap between samples restarts the channel, 0 = never
+};
+
+/**
+ * @brief Classification of the oscillation envelope, see BasicOscillatorDetector::envelope().
+ */
+enum class OscillatorEnvelope : uint8_t {
+    Unknown,    // fewer than three swings seen so far
+    Decaying,
+    Steady,
+    Growing,
+};
+
+/**
+ * @brief Envelope tracking state.
+ *
+ * Unlike the extrema counting, which only accepts non-shrinking peaks and
+ * troughs, the envelope follows every alternating turning point of the
+ * signal, so damped oscillations are measured as well.
+ */
+struct OscillatorEnvelopeState {
+    int64_t lastTurnPos{ 0 };       // position of the last accepted peak or trough
+    uint32_t swing{ 0 };            // distance from the previous turn to lastTurnPos
+    uint32_t previousSwing{ 0 };    // the swing before that
+    uint32_t halfPeriod{ 0 };       // smoothed samples between turns, Q8, 0 = unknown
+    uint16_t growth{ 0 };           // smoothed swing ratio per half period, Q12 (4096 = steady), 0 = unknown
+    uint16_t samplesSinceTurn{ 0 }; // saturating
+    uint16_t turnSpacing{ 0 };      // samples from the previous turn to lastTurnPos
+    int8_t lastTurn{ 0 };           // +1 peak, -1 trough, 0 none yet
+};
+
+/**
+ * @brief Internal state of an OscillatorDetector.
+ *
+ * Exposed so that reset policies (and tools built on top of the detector) can
+ * operate on it; it is not meant to be modified by regular users.
+ */
+struct OscillatorDetectorState {
+    uint8_t extremaCounter{ 0 };
+    int lastDirection{ 0 };
+    int64_t minFoundPos{ std::numeric_limits<int64_t>::max() };
+    int64_t maxFoundPos{ std::numeric_limits<int64_t>::min() };
+    uint8_t minimumDebounceCounter{ 0 };
+    uint8_t maximumDebounceCounter{ 0 };
+    uint16_t holdOffCounter{ 0 };
+    uint16_t exitCountdown{ 0 };            // quiet units left before a detection ends, see exitDelay
+
+    // Statistics of the counted extrema, used by the confidence score.
+    uint16_t samplesSinceExtremum{ 0 };     // saturating
+    uint16_t halfPeriod{ 0 };               // samples between the last two confirmed extrema
+    uint16_t halfPeriodJitter{ 0 };         // running mean of |spacing change|
+
+    // Not affected by the reset policy.
+    OscillatorEnvelopeState envelope;
+    uint16_t flipRate{ 0 };                 // Q15 share of samples that reverse the direction, ~32 sample horizon
+};
+
+/**
+ * @brief Additional state of timestamped updates, see BasicOscillatorDetector::stepTimed().
+ */
+struct OscillatorTimingState {
+    int64_t lastTimestamp{ std::numeric_limits<int64_t>::min() };   // min: no sample yet
+    int64_t lastExtremumTime{ 0 };
+    int64_t maximumDebounceStart{ 0 };  // time of the first update that reached the tracked maximum
+    int64_t minimumDebounceStart{ 0 };
+    int64_t maximumDebounceTime{ 0 };   // time from maximumDebounceStart to the latest such update, in ns
+    int64_t minimumDebounceTime{ 0 };
+};
+
+/**
+ * @brief Additional state of the velocity and acceleration modes, see BasicOscillatorDetector::derive().
+ */
+struct OscillatorDerivativeState {
+    int64_t lastPosition{ 0 };
+    int64_t velocity{ 0 };          // smoothed first difference, scaled by 2^derivativeSmoothing
+    int64_t acceleration{ 0 };      // smoothed difference of velocity, scaled by 4^derivativeSmoothing
+    int64_t lastDerived{ 0 };
+    uint8_t samples{ 0 };           // samples seen, saturating at 3
+};
+
+/**
+ * @brief Flags describing what happened during one detector update.
+ */
+namespace OscillatorEvent {
+    enum : uint8_t {
+        Detected = 1 << 0,  // oscillation reported (detect() returns true)
+        Extremum = 1 << 1,  // a new extremum has been counted
+        Reset = 1 << 2,     // the reset policy has been applied
+        Maximum = 1 << 3,   // with Extremum: the counted extremum is a maximum
+    };
+}
+
+/**
+ * @brief Decisions of one extremum state machine update, see BasicOscillatorDetector::classify().
+ */
+namespace OscillatorAction {
+    enum : uint8_t {
+        MaximumFound = 1 << 0,      // direction turned from rising to falling/stopped
+        MinimumFound = 1 << 1,      // direction turned from falling to rising/stopped
+        MaximumReached = 1 << 2,    // ... at or beyond the tracked maximum
+        MinimumReached = 1 << 3,    // ... at or beyond the tracked minimum
+        CountMaximum = 1 << 4,      // the maximum is counted as a new extremum
+        CountMinimum = 1 << 5,      // the minimum is counted as a new extremum
+        Reset = 1 << 6,             // the reset policy is applied
+    };
+}
+
+
+/**
+ * @brief Reset policies used when the debounce logic decides that the
+ *        oscillation has stopped.
+ *
+ * A policy is a type with a static
+ * `apply(OscillatorDetectorState&, int64_t position, bool reset)` function.
+ * The detector calls it on every update; the policy writes only the fields it
+ * changes, each as `field = reset ? value : field`, so the update stays free
+ * of branches and costs a few selects. It is called before `lastDirection` is
+ * updated, so `state.lastDirection > 0` means the reset was triggered at a
+ * maximum and `state.lastDirection < 0` at a minimum. The hold-off, the exit
+ * countdown, the envelope and the flip rate belong to the detector and are
+ * not touched by the policies.
+ */
+namespace OscillatorReset {
+
+    /**
+     * @brief Forget everything (default, original behavior).
+     */
+    struct Full {
+        static void apply(OscillatorDetectorState& state, int64_t, bool reset) {
+            state.extremaCounter = reset ? uint8_t{ 0 } : state.extremaCounter;
+            state.minFoundPos = reset ? std::numeric_limits<int64_t>::max() : state.minFoundPos;
+            state.maxFoundPos = reset ? std::numeric_limits<int64_t>::min() : state.maxFoundPos;
+            state.minimumDebounceCounter = reset ? uint8_t{ 0 } : state.minimumDebounceCounter;
+            state.maximumDebounceCounter = reset ? uint8_t{ 0 } : state.maximumDebounceCounter;
+            state.samplesSinceExtremum = reset ? uint16_t{ 0 } : state.samplesSinceExtremum;
+            state.halfPeriod = reset ? uint16_t{ 0 } : state.halfPeriod;
+            state.halfPeriodJitter = reset ? uint16_t{ 0 } : state.halfPeriodJitter;
+        }
+    };
+
+    /**
+     * @brief Drop a single extremum from the count and keep the tracked extrema.
+     *
+     * A short dip out of oscillation costs one extremum instead of the whole count.
+     */
+    struct Decrement {
+        static void apply(OscillatorDetectorState& state, int64_t, bool reset) {
+            state.extremaCounter = static_cast<uint8_t>(state.extremaCounter - ((state.extremaCounter > 0) & reset));
+            state.minimumDebounceCounter = reset ? uint8_t{ 0 } : state.minimumDebounceCounter;
+            state.maximumDebounceCounter = reset ? uint8_t{ 0 } : state.maximumDebounceCounter;
+        }
+    };
+
+    /**
+     * @brief Slide the counting window: keep the most recent half of the extrema.
+     *
+     * The tracked extrema are forgotten so that the next peak and trough are
+     * judged against the new signal level.
+     */
+    struct Sliding {
+        static void apply(OscillatorDetectorState& state, int64_t, bool reset) {
+            state.extremaCounter = static_cast<uint8_t>(state.extremaCounter >> reset);
+            state.minFoundPos = reset ? std::numeric_limits<int64_t>::max() : state.minFoundPos;
+            state.maxFoundPos = reset ? std::numeric_limits<int64_t>::min() : state.maxFoundPos;
+            state.minimumDebounceCounter = reset ? uint8_t{ 0 } : state.minimumDebounceCounter;
+            state.maximumDebounceCounter = reset ? uint8_t{ 0 } : state.maximumDebounceCounter;
+        }
+    };
+
+    /**
+     * @brief Restart counting from the extremum that triggered the reset.
+     *
+     * The current position becomes the first extremum of a new run, so an
+     * oscillation already in progress does not have to be re-learned.
+     */
+    struct KeepLastExtremum {
+        static void apply(OscillatorDetectorState& state, int64_t position, bool reset) {
+            const bool atMaximum = state.lastDirection > 0;
+            state.extremaCounter = reset ? uint8_t{ 1 } : state.extremaCounter;
+            state.maxFoundPos = reset ? (atMaximum ? position : std::numeric_limits<int64_t>::min()) : state.maxFoundPos;
+            state.minFoundPos = reset ? (atMaximum ? std::numeric_limits<int64_t>::max() : position) : state.minFoundPos;
+            state.maximumDebounceCounter = reset ? uint8_t{ atMaximum } : state.maximumDebounceCounter;
+            state.minimumDebounceCounter = reset ? uint8_t{ !atMaximum } : state.minimumDebounceCounter;
+        }
+    };
+
+} // namespace OscillatorReset
 
 
 /**
@@ -52,11 +273,17 @@
  *  - Call detect(position, direction) with the current signal value and its
  *    direction of change (-1 = falling, 0 = stopped, 1 = rising).
  *  - Detection parameters can be read or modified using the getter/setter methods.
+ *  - An optional hold-off (setHoldOff) limits how often detect() reports true
+ *    while an oscillation persists.
+ *
+ * @tparam ResetPolicy What happens to the internal state when the oscillation
+ *         is considered stopped, see OscillatorReset. Resolved at compile time.
  */
-class OscillatorDetector {
+template <typename ResetPolicy = OscillatorReset::Full>
+class BasicOscillatorDetector {
 public:
-    OscillatorDetector() = default;
-    ~OscillatorDetector() = default;
+    BasicOscillatorDetector() = default;
+    ~BasicOscillatorDetector() = default;
 
     /**
      * @brief Detects oscillatory behavior by tracking local maxima and minima.
@@ -70,47 +297,400 @@ public:
      *                  -1 = falling
      *                   0 = stopped
      *                   1 = rising
-     * @return true if the number of detected extrema exceeds the sensitivity threshold.
+     * @return true if the number of detected extrema exceeds the sensitivity threshold
+     *         and no hold-off period is running.
      */
     bool detect(int64_t position, int direction) {
-        bool reset{ false };
-        bool maximumFound = (m_internals.lastDirection > 0 && direction <= 0);
-        bool minimumFound = (m_internals.lastDirection < 0 && direction >= 0);
-
-        if (maximumFound) {
-            if (m_internals.maxFoundPos <= position && m_internals.maximumDebounceCounter++ == 0) {
-                ++m_internals.extremaCounter;
-                m_internals.maxFoundPos = position;
-                m_internals.minimumDebounceCounter = 0;
-            }
-            else if (m_internals.maxFoundPos <= position) {
-                m_internals.maxFoundPos = position;
-            }
-            else if (m_internals.maximumDebounceCounter > m_params.smootherThreshold) {
-                reset = true;
-            }
+        return (update(position, direction) & OscillatorEvent::Detected) != 0;
+    }
+
+    /**
+     * @brief Same as detect(), but reports everything that happened during the update.
+     * @return A combination of OscillatorEvent flags.
+     */
+    uint8_t update(int64_t position, int direction) {
+        if (m_params.derivative != OscillatorDerivative::Position) {
+            position = derive(m_params, m_derivative.acquire(), position, direction);
         }
+        return step(m_params, m_internals, position, direction);
+    }
 
-        if (minimumFound) {
-            if (m_internals.minFoundPos >= position && m_internals.minimumDebounceCounter++ == 0) {
-                ++m_internals.extremaCounter;
-                m_internals.minFoundPos = position;
-                m_internals.maximumDebounceCounter = 0;
-            }
-            else if (m_internals.minFoundPos >= position) {
-                m_internals.minFoundPos = position;
-            }
-            else if (m_internals.minimumDebounceCounter > m_params.smootherThreshold) {
-                reset = true;
-            }
+    /**
+     * @brief Update the detector and report the severity levels reached, see severity().
+     * @return A bitmask with bit i set while severity level i is reached.
+     */
+    uint8_t detectSeverity(int64_t position, int direction) {
+        update(position, direction);
+        return getSeverity();
+    }
+
+    /**
+     * @brief Detect oscillation with timestamped samples, for irregular sampling.
+     *
+     * Same as detect(position, direction), but the debounce is measured in time:
+     * the dwell at the tracked extremum is the time from the first update that
+     * reached it to the latest one, whatever the sample spacing in between, and
+     * the reset path is armed once this dwell exceeds smootherTime. With a detectionWindow, a count whose last extremum is older
+     * than the window is dropped through the reset policy. After a gap longer
+     * than staleAfter the detector starts over and reports Reset.
+     * @param timestamp Sample time in nanoseconds, non-decreasing.
+     */
+    bool detect(int64_t position, int direction, int64_t timestamp) {
+        return (update(position, direction, timestamp) & OscillatorEvent::Detected) != 0;
+    }
+
+    /**
+     * @brief Same as detect(position, direction, timestamp), returning OscillatorEvent flags.
+     */
+    uint8_t update(int64_t position, int direction, int64_t timestamp) {
+        if (m_params.derivative != OscillatorDerivative::Position) {
+            position = derive(m_params, m_derivative.acquire(), position, direction);
+        }
+        return stepTimed(m_params, m_internals, m_timing.acquire(), position, direction, timestamp);
+    }
+
+    /**
+     * @brief The detection kernel behind detect(), usable on external state.
+     *
+     * Detector banks run this on every channel so a bank channel behaves exactly
+     * like a standalone detector with the same parameters. It is classify()
+     * followed by transition(), so it has one data-dependent branch, taken at
+     * turning points.
+     * @return A combination of OscillatorEvent flags.
+     */
+    static uint8_t step(const OscillatorDetectorParams& params, OscillatorDetectorState& state,
+                        int64_t position, int direction) {
+        trackNoise(state, direction);
+        return transition(params, state, position, direction, classify(params, state, position, direction));
+    }
+
+    /**
+     * @brief Same as step(), with the decisions looked up in a transition table, see classifyTable().
+     */
+    static uint8_t stepTable(const OscillatorDetectorParams& params, OscillatorDetectorState& state,
+                             int64_t position, int direction) {
+        trackNoise(state, direction);
+        return transition(params, state, position, direction, classifyTable(params, state, position, direction));
+    }
+
+    /**
+     * @brief The kernel behind the timestamped detect(); integer nanosecond arithmetic only.
+     */
+    static uint8_t stepTimed(const OscillatorDetectorParams& params, OscillatorDetectorState& state,
+                             OscillatorTimingState& timing, int64_t position, int direction, int64_t timestamp) {
+        // A channel that has been silent for longer than staleAfter starts over.
+        // The differences wrap instead of overflowing and are only used once primed.
+        const bool primed = timing.lastTimestamp != std::numeric_limits<int64_t>::min();
+        const bool stale = (params.staleAfter > 0) & primed & (since(timestamp, timing.lastTimestamp) > params.staleAfter);
+        selectState(stale, state, OscillatorDetectorState{});
+        selectTiming(stale, timing, OscillatorTimingState{});
+
+        trackNoise(state, direction);
+        const bool maximumIdle = state.maximumDebounceCounter == 0;
+        const bool minimumIdle = state.minimumDebounceCounter == 0;
+        const bool expired = (params.detectionWindow > 0) & (state.extremaCounter > 0) &
+                             (since(timestamp, timing.lastExtremumTime) > params.detectionWindow);
+
+        uint8_t action = decide(state, position, direction,
+                                timing.maximumDebounceTime > params.smootherTime,
+                                timing.minimumDebounceTime > params.smootherTime);
+        action = static_cast<uint8_t>(action | (expired ? OscillatorAction::Reset : 0));
+        const uint8_t events = transition(params, state, position, direction, action);
+
+        // The dwell runs from the update that started the debounce to the latest
+        // one that reached the extremum; updates in between do not add to it.
+        const bool maximumActive = state.maximumDebounceCounter != 0;
+        const bool minimumActive = state.minimumDebounceCounter != 0;
+        timing.maximumDebounceStart = maximumIdle & maximumActive ? timestamp : timing.maximumDebounceStart;
+        timing.minimumDebounceStart = minimumIdle & minimumActive ? timestamp : timing.minimumDebounceStart;
+        const int64_t maximumDwell = (action & OscillatorAction::MaximumReached) ? since(timestamp, timing.maximumDebounceStart) : timing.maximumDebounceTime;
+        const int64_t minimumDwell = (action & OscillatorAction::MinimumReached) ? since(timestamp, timing.minimumDebounceStart) : timing.minimumDebounceTime;
+        timing.maximumDebounceTime = maximumActive ? maximumDwell : 0;
+        timing.minimumDebounceTime = minimumActive ? minimumDwell : 0;
+        timing.lastExtremumTime = ((events & OscillatorEvent::Extremum) != 0) | expired ? timestamp : timing.lastExtremumTime;
+        timing.lastTimestamp = timestamp;
+        return static_cast<uint8_t>(events | (stale ? OscillatorEvent::Reset : 0));
+    }
+
+    /**
+     * @brief Decide what an update does, from predicates and masked logic.
+     *
+     * Written as predicates rather than nested branches, so that a loop running
+     * it over many channels can be if-converted. The logic is that of the
+     * original branch tree:
+     *  - a maximum/minimum at or beyond the tracked one bumps its debounce
+     *    counter and moves the tracked extremum; if the debounce counter was
+     *    zero the extremum is counted and the opposite counter is cleared,
+     *  - a lower maximum/higher minimum after more than smootherThreshold
+     *    debounce updates triggers the reset policy.
+     * @return A combination of OscillatorAction flags.
+     */
+    static uint8_t classify(const OscillatorDetectorParams& params, const OscillatorDetectorState& state,
+                            int64_t position, int direction) {
+        const uint8_t threshold = smootherThreshold(params, state);
+        return decide(state, position, direction,
+                      state.maximumDebounceCounter > threshold, state.minimumDebounceCounter > threshold);
+    }
+
+    /**
+     * @brief Decide what an update does with one table lookup.
+     *
+     * The ten input predicates (signs of lastDirection and direction, the two
+     * position comparisons, and the zero/above-threshold tests of both debounce
+     * counters) are packed into a 10-bit index into a precomputed table of
+     * OscillatorAction flags. The result is identical to classify().
+     */
+    static uint8_t classifyTable(const OscillatorDetectorParams& params, const OscillatorDetectorState& state,
+                                 int64_t position, int direction) {
+        const uint8_t threshold = smootherThreshold(params, state);
+        const unsigned index = static_cast<unsigned>(state.lastDirection > 0)
+                             | static_cast<unsigned>(state.lastDirection < 0) << 1
+                             | static_cast<unsigned>(direction > 0) << 2
+                             | static_cast<unsigned>(direction < 0) << 3
+                             | static_cast<unsigned>(state.maxFoundPos <= position) << 4
+                             | static_cast<unsigned>(state.minFoundPos >= position) << 5
+                             | static_cast<unsigned>(state.maximumDebounceCounter == 0) << 6
+                             | static_cast<unsigned>(state.minimumDebounceCounter == 0) << 7
+                             | static_cast<unsigned>(state.maximumDebounceCounter > threshold) << 8
+                             | static_cast<unsigned>(state.minimumDebounceCounter > threshold) << 9;
+        return s_transitions[index];
+    }
+
+    /**
+     * @brief Apply the decisions of classify()/classifyTable() to the state.
+     *
+     * Selects throughout, except for the envelope bookkeeping, which runs
+     * behind a branch at turning points only (see recordTurn()).
+     * @return A combination of OscillatorEvent flags.
+     */
+    static uint8_t transition(const OscillatorDetectorParams& params, OscillatorDetectorState& state,
+                              int64_t position, int direction, uint8_t action) {
+        const bool maximumFound = (action & OscillatorAction::MaximumFound) != 0;
+        const bool minimumFound = (action & OscillatorAction::MinimumFound) != 0;
+        const bool maximumReached = (action & OscillatorAction::MaximumReached) != 0;
+        const bool minimumReached = (action & OscillatorAction::MinimumReached) != 0;
+        const bool countMaximum = (action & OscillatorAction::CountMaximum) != 0;
+        const bool countMinimum = (action & OscillatorAction::CountMinimum) != 0;
+        const bool confirmed = countMaximum | countMinimum;
+        const bool reset = (action & OscillatorAction::Reset) != 0;
+
+        // Band gate: a confirmed extremum only counts if it follows the previous
+        // one within [minHalfPeriod, maxHalfPeriod] samples (the first always counts).
+        // The spacing saturates like samplesSinceExtremum, so the default band passes everything.
+        constexpr uint16_t maxSamples = std::numeric_limits<uint16_t>::max();
+        const uint32_t spacing = state.samplesSinceExtremum + (state.samplesSinceExtremum < maxSamples);
+        const bool inBand = (state.extremaCounter == 0) |
+                            ((spacing >= params.minHalfPeriod) & (spacing <= params.maxHalfPeriod));
+        const bool counted = confirmed & inBand;
+
+        state.maximumDebounceCounter = static_cast<uint8_t>(state.maximumDebounceCounter + maximumReached);
+        state.minimumDebounceCounter = static_cast<uint8_t>(state.minimumDebounceCounter + minimumReached);
+        state.maximumDebounceCounter = countMinimum ? uint8_t{ 0 } : state.maximumDebounceCounter;
+        state.minimumDebounceCounter = countMaximum ? uint8_t{ 0 } : state.minimumDebounceCounter;
+        state.maxFoundPos = maximumReached ? position : state.maxFoundPos;
+        state.minFoundPos = minimumReached ? position : state.minFoundPos;
+        state.extremaCounter = static_cast<uint8_t>(state.extremaCounter + counted);
+
+        recordExtremum(state, confirmed);
+        // Turns are rare next to plain samples, so the branch predicts well and
+        // the envelope bookkeeping (with its divide) only runs at a turn.
+        if (maximumFound | minimumFound) {
+            recordTurn(state.envelope, maximumFound, position);
         }
+        else {
+            constexpr uint16_t maxTurnSamples = std::numeric_limits<uint16_t>::max();
+            state.envelope.samplesSinceTurn = static_cast<uint16_t>(state.envelope.samplesSinceTurn + (state.envelope.samplesSinceTurn < maxTurnSamples));
+        }
+
+        // Only the fields the policy touches; a running hold-off or exit countdown survives a reset.
+        ResetPolicy::apply(state, position, reset);
+
+        state.lastDirection = direction;
 
-        if (reset) {
-            m_internals = {}; // reset all internals to their default-initialized values
+        // Hold-off: suppress while it runs; on a fresh detection re-arm by restarting
+        // only the extrema count, so an ongoing oscillation is picked up right away.
+        const bool holding = state.holdOffCounter > 0;
+        const bool entered = !holding & (state.extremaCounter > params.sensitivity);
+        const bool rearm = entered & (params.holdOff > 0);
+
+        // Exit hysteresis: after the condition clears (e.g. a debounce reset), the
+        // detection lasts until exitDelay consecutive samples have been quiet.
+        const bool lingering = !holding & !entered & (state.exitCountdown > 0);
+        const bool detected = entered | lingering;
+        state.exitCountdown = static_cast<uint16_t>(entered ? params.exitDelay : state.exitCountdown - lingering);
+        state.holdOffCounter = static_cast<uint16_t>(holding ? state.holdOffCounter - 1 : (rearm ? params.holdOff : 0));
+        state.extremaCounter = rearm ? uint8_t{ 0 } : state.extremaCounter;
+
+        return static_cast<uint8_t>((detected ? OscillatorEvent::Detected : 0) |
+                                    (counted ? OscillatorEvent::Extremum : 0) |
+                                    (reset ? OscillatorEvent::Reset : 0) |
+                                    (countMaximum & inBand ? OscillatorEvent::Maximum : 0));
+    }
+
+    /**
+     * @brief Debounce threshold in effect for a channel.
+     *
+     * With noiseGain 0 this is the fixed smootherThreshold. Otherwise it follows
+     * the measured noise: 1 + flipRate * noiseGain / 8192, i.e. a channel whose
+     * direction reverses on every other sample gets about 2 * noiseGain, a clean
+     * one gets 1. Branch-free, O(1).
+     */
+    static uint8_t smootherThreshold(const OscillatorDetectorParams& params, const OscillatorDetectorState& state) {
+        const uint32_t adaptive = 1u + ((static_cast<uint32_t>(state.flipRate) * params.noiseGain) >> 13);
+        const uint8_t limited = static_cast<uint8_t>(adaptive < 255u ? adaptive : 255u);
+        return params.noiseGain == 0 ? params.smootherThreshold : limited;
+    }
+
+    /**
+     * @brief Derive the tracked signal of the velocity and acceleration modes.
+     *
+     * Velocity is the first difference of the positions and acceleration the
+     * difference of the velocity. Each difference passes through an integer
+     * EMA with weight 2^-derivativeSmoothing. The result keeps the fraction bits
+     * of the EMA (scaled by 2^n for velocity, 4^n for acceleration), which the
+     * detector does not mind since it only compares values. The direction is
+     * the sign of the change of the derived value, 0 until it is known.
+     * @param position Input sample.
+     * @param direction Receives the direction of the derived signal.
+     * @return The derived value to pass to step() in place of the position.
+     */
+    static int64_t derive(const OscillatorDetectorParams& params, OscillatorDerivativeState& state,
+                          int64_t position, int& direction) {
+        const unsigned shift = params.derivativeSmoothing;
+        const uint8_t seen = state.samples;
+
+        // Each EMA starts at its first value instead of ramping up from zero.
+        const int64_t difference = position - state.lastPosition;
+        const int64_t smoothedVelocity = state.velocity + difference - (state.velocity >> shift);
+        const int64_t velocity = seen == 1 ? difference << shift : (seen > 1 ? smoothedVelocity : 0);
+        const int64_t change = velocity - state.velocity;
+        const int64_t smoothedAcceleration = state.acceleration + change - (state.acceleration >> shift);
+        const int64_t acceleration = seen == 2 ? change << shift : (seen > 2 ? smoothedAcceleration : 0);
+
+        const bool second = params.derivative == OscillatorDerivative::Acceleration;
+        const int64_t derived = second ? acceleration : velocity;
+        const bool known = seen > 1 + second;
+        const int64_t delta = derived - state.lastDerived;
+        direction = known ? (delta > 0) - (delta < 0) : 0;
+
+        state.lastPosition = position;
+        state.velocity = velocity;
+        state.acceleration = acceleration;
+        state.lastDerived = derived;
+        state.samples = static_cast<uint8_t>(seen < 3 ? seen + 1 : 3);
+        return derived;
+    }
+
+    /**
+     * @brief Severity levels reached by a channel, as a bitmask.
+     *
+     * Bit i is set while the extrema count exceeds severityLevels[i] and no
+     * hold-off is running, so several alert tiers share one detector. With
+     * ascending levels the mask is contiguous and std::bit_width() of it is
+     * the highest level reached. Note that a hold-off restarts the count on
+     * every detection, so levels above the sensitivity need holdOff 0.
+     */
+    static uint8_t severity(const OscillatorDetectorParams& params, const OscillatorDetectorState& state) {
+        return severity(params, state.extremaCounter, state.holdOffCounter);
+    }
+
+    /**
+     * @brief Same as severity(params, state), from the two state fields it reads.
+     */
+    static uint8_t severity(const OscillatorDetectorParams& params, uint8_t extremaCounter, uint16_t holdOffCounter) {
+        uint8_t mask = 0;
+        for (std::size_t level = 0; level < params.severityLevels.size(); ++level) {
+            mask |= static_cast<uint8_t>((extremaCounter > params.severityLevels[level]) << level);
+        }
+        return holdOffCounter == 0 ? mask : uint8_t{ 0 };
+    }
+
+    /**
+     * @brief Graded oscillation confidence derived from the detector state.
+     *
+     * The score combines three terms:
+     *  - up to 32767 for the extrema count relative to the sensitivity,
+     *  - up to 16384 for a growing envelope (saturating at +12.5% per half period),
+     *  - up to 16384 for regular spacing between counted extrema.
+     * A steady, regular oscillation above the sensitivity scores about 49000,
+     * a growing one up to 65535. O(1), no state is modified.
+     * @return The score, higher means more urgent.
+     */
+    static uint16_t score(const OscillatorDetectorParams& params, const OscillatorDetectorState& state) {
+        return score(params, state.extremaCounter, state.envelope.growth, state.halfPeriod, state.halfPeriodJitter);
+    }
+
+    /**
+     * @brief Same as score(params, state), from the four state fields it reads.
+     */
+    static uint16_t score(const OscillatorDetectorParams& params, uint8_t extremaCounter, uint16_t envelopeGrowth,
+                          uint16_t halfPeriod, uint16_t halfPeriodJitter) {
+        // Conversions go through int32_t, which loops over channels can vectorize.
+        const float limit = static_cast<float>(params.sensitivity) + 1.0f;
+        const float count = static_cast<float>(static_cast<int32_t>(extremaCounter));
+        const float countTerm = (count < limit ? count : limit) / limit;
+
+        const float growth = (static_cast<float>(static_cast<int32_t>(envelopeGrowth)) - 4096.0f) / 512.0f;
+        const float trendTerm = growth < 0.0f ? 0.0f : (growth > 1.0f ? 1.0f : growth);
+
+        // Relative spacing jitter of 25% or more counts as irregular.
+        const float period = static_cast<float>(static_cast<int32_t>(halfPeriod));
+        const float jitter = 4.0f * static_cast<float>(static_cast<int32_t>(halfPeriodJitter));
+        const float regularityTerm = ((count >= 2.0f) & (jitter < period)) ? 1.0f - jitter / (period > 0.0f ? period : 1.0f) : 0.0f;
+
+        return static_cast<uint16_t>(static_cast<int32_t>(countTerm * 32767.0f + trendTerm * 16384.0f + regularityTerm * 16384.0f));
+    }
+
+    /**
+     * @brief Classify the oscillation envelope from the smoothed swing ratio.
+     *
+     * The swing ratio is measured between successive half periods (peak to
+     * trough, trough to peak) and smoothed over roughly the last four of them.
+     * @return Growing/Decaying when the ratio leaves the band of
+     *         1 +- envelopeTolerance, Steady inside it, Unknown before the
+     *         first ratio has been measured.
+     */
+    static OscillatorEnvelope envelope(const OscillatorDetectorParams& params, const OscillatorDetectorState& state) {
+        const int32_t growth = state.envelope.growth;
+        if (growth == 0) {
+            return OscillatorEnvelope::Unknown;
+        }
+        if (growth > 4096 + params.envelopeTolerance) {
+            return OscillatorEnvelope::Growing;
+        }
+        if (growth < 4096 - params.envelopeTolerance) {
+            return OscillatorEnvelope::Decaying;
         }
+        return OscillatorEnvelope::Steady;
+    }
 
-        m_internals.lastDirection = direction;
-        return m_internals.extremaCounter > m_params.sensitivity;
+    /**
+     * @brief Damping ratio estimated from the envelope growth (logarithmic decrement).
+     *
+     * With r the swing ratio per half period, the logarithmic decrement per
+     * period is delta = -2 ln(r) and zeta = delta / sqrt(4 pi^2 + delta^2).
+     * @param growth OscillatorEnvelopeState::growth.
+     * @return zeta (negative for a growing oscillation), 0 while unknown.
+     */
+    static float dampingRatio(uint16_t growth) {
+        const float decrement = -2.0f * logarithm(static_cast<float>(growth | (growth == 0)) * (1.0f / 4096.0f));
+        const float ratio = decrement * inverseSquareRoot(4.0f * 9.8696044f + decrement * decrement);
+        return std::bit_cast<float>(std::bit_cast<uint32_t>(ratio) & (0u - (growth != 0))); // 0 if unknown
+    }
+
+    /**
+     * @brief Undamped natural frequency estimated from the turn spacing and the damping.
+     *
+     * The damped frequency is 1 / (2 * halfPeriod) and fn = fd / sqrt(1 - zeta^2).
+     * @param growth OscillatorEnvelopeState::growth.
+     * @param halfPeriod OscillatorEnvelopeState::halfPeriod.
+     * @return fn in cycles per sample, 0 while unknown.
+     */
+    static float naturalFrequency(uint16_t growth, uint32_t halfPeriod) {
+        const float zeta = dampingRatio(growth);
+        const float damped = 128.0f / static_cast<float>(halfPeriod | (halfPeriod == 0)); // 256 / (2 * Q8 half period)
+        const float frequency = damped * inverseSquareRoot(1.0f - zeta * zeta);
+        return std::bit_cast<float>(std::bit_cast<uint32_t>(frequency) & (0u - ((growth != 0) & (halfPeriod != 0))));
     }
 
     /**
@@ -129,6 +709,101 @@ public:
         m_params.sensitivity = sensitivity;
     }
 
+    /**
+     * @brief Set the hold-off period that follows a reported detection.
+     *
+     * After detect() returns true it returns false for the next `samples` calls
+     * and the extrema count restarts from zero, so a persisting oscillation is
+     * reported at most once per `samples + 1` calls. 0 disables the hold-off.
+     * @param samples Number of detect() calls during which detections are suppressed.
+     */
+    void setHoldOff(uint16_t samples) {
+        m_params.holdOff = samples;
+    }
+
+    /**
+     * @brief Track the velocity or acceleration of the input instead of the input itself.
+     *
+     * In the derived modes the detector computes the differences and their
+     * direction itself, see derive(); the direction passed to detect() is ignored.
+     * @param derivative Signal to track.
+     * @param smoothing EMA weight 2^-smoothing on each difference, 0 = none;
+     *        at most 62, larger values are clamped so the shifts stay defined.
+     */
+    void setDerivative(OscillatorDerivative derivative, uint8_t smoothing = 0) {
+        m_params.derivative = derivative;
+        m_params.derivativeSmoothing = std::min(smoothing, uint8_t{ 62 });
+    }
+
+    /**
+     * @brief Set the exit hysteresis of the detection output.
+     *
+     * A detection is entered when the extrema count exceeds the sensitivity and,
+     * once entered, lasts until `samples` consecutive updates have not met that
+     * condition. A debounce reset that clears the count therefore does not end
+     * it right away, which stops the output from chattering under marginal
+     * oscillation. 0 (the default) ends it with the condition.
+     * @param samples Quiet updates needed to end a detection.
+     */
+    void setExitDelay(uint16_t samples) {
+        m_params.exitDelay = samples;
+    }
+
+    /**
+     * @brief Count only extrema that follow the previous one within a band of spacings.
+     *
+     * A confirmed extremum adds to the extrema count only if it comes
+     * [minimum, maximum] samples after the previous confirmed one, which selects
+     * half periods in that band without filtering the signal. An extremum outside
+     * the band still moves the tracked extremum and restarts the spacing.
+     * 0 and 65535 (the defaults) count everything.
+     * @param minimum, maximum Half period band in samples (updates).
+     */
+    void setHalfPeriodBand(uint16_t minimum, uint16_t maximum) {
+        m_params.minHalfPeriod = minimum;
+        m_params.maxHalfPeriod = maximum;
+    }
+
+    /**
+     * @brief Set the band around a swing ratio of 1 that is classified as steady.
+     * @param tolerance Q12 fixed point, e.g. 64 = +-1.6% per half period.
+     */
+    void setEnvelopeTolerance(uint16_t tolerance) {
+        m_params.envelopeTolerance = tolerance;
+    }
+
+    /**
+     * @brief Enable the adaptive debounce threshold, see smootherThreshold().
+     * @param gain Threshold per unit flip rate / 2; 0 uses the fixed smoothing threshold.
+     */
+    void setNoiseGain(uint8_t gain) {
+        m_params.noiseGain = gain;
+    }
+
+    /**
+     * @brief Set the debounce dwell of timestamped updates.
+     * @param nanoseconds Time at the tracked extremum after which a lower one triggers a reset.
+     */
+    void setSmootherTime(int64_t nanoseconds) {
+        m_params.smootherTime = nanoseconds;
+    }
+
+    /**
+     * @brief Set the detection window of timestamped updates.
+     * @param nanoseconds Longest gap between counted extrema; 0 disables the window.
+     */
+    void setDetectionWindow(int64_t nanoseconds) {
+        m_params.detectionWindow = nanoseconds;
+    }
+
+    /**
+     * @brief Set the gap after which timestamped updates restart the detector.
+     * @param nanoseconds Longest gap between samples; 0 never restarts. A restart reports Reset.
+     */
+    void setStaleAfter(int64_t nanoseconds) {
+        m_params.staleAfter = nanoseconds;
+    }
+
     /**
      * @brief Get the current smoothing threshold.
      * @return The smoothing threshold value.
@@ -137,6 +812,21 @@ public:
         return m_params.smootherThreshold;
     }
 
+    /**
+     * @brief Set the extrema counts above which each severity level is reached, see severity().
+     * @param levels Ascending counts, e.g. { 5, 10, 255, 255 } for warning and critical; 255 leaves a level unused.
+     */
+    void setSeverityLevels(const std::array<uint8_t, 4>& levels) {
+        m_params.severityLevels = levels;
+    }
+
+    /**
+     * @brief Get the severity level thresholds.
+     */
+    const std::array<uint8_t, 4>& getSeverityLevels() const {
+        return m_params.severityLevels;
+    }
+
     /**
      * @brief Get the current sensitivity threshold.
      * @return The sensitivity threshold value.
@@ -145,18 +835,389 @@ public:
         return m_params.sensitivity;
     }
 
+    /**
+     * @brief Get the current hold-off period.
+     * @return The hold-off period in detect() calls.
+     */
+    uint16_t getHoldOff() const {
+        return m_params.holdOff;
+    }
+
+    /**
+     * @brief Get the tracked signal.
+     */
+    OscillatorDerivative getDerivative() const {
+        return m_params.derivative;
+    }
+
+    /**
+     * @brief Get the EMA weight exponent of the derived modes.
+     */
+    uint8_t getDerivativeSmoothing() const {
+        return m_params.derivativeSmoothing;
+    }
+
+    /**
+     * @brief Get the exit hysteresis in quiet updates.
+     */
+    uint16_t getExitDelay() const {
+        return m_params.exitDelay;
+    }
+
+    /**
+     * @brief Get the shortest counted half period in samples.
+     */
+    uint16_t getMinHalfPeriod() const {
+        return m_params.minHalfPeriod;
+    }
+
+    /**
+     * @brief Get the longest counted half period in samples.
+     */
+    uint16_t getMaxHalfPeriod() const {
+        return m_params.maxHalfPeriod;
+    }
+
+    /**
+     * @brief Get the current steady-envelope tolerance (Q12).
+     */
+    uint16_t getEnvelopeTolerance() const {
+        return m_params.envelopeTolerance;
+    }
+
+    /**
+     * @brief Get the adaptive threshold gain (0 = fixed threshold).
+     */
+    uint8_t getNoiseGain() const {
+        return m_params.noiseGain;
+    }
+
+    /**
+     * @brief Get the debounce dwell of timestamped updates (ns).
+     */
+    int64_t getSmootherTime() const {
+        return m_params.smootherTime;
+    }
+
+    /**
+     * @brief Get the detection window of timestamped updates (ns, 0 = unlimited).
+     */
+    int64_t getDetectionWindow() const {
+        return m_params.detectionWindow;
+    }
+
+    /**
+     * @brief Get the gap after which timestamped updates restart the detector (ns, 0 = never).
+     */
+    int64_t getStaleAfter() const {
+        return m_params.staleAfter;
+    }
+
+    /**
+     * @brief Get the debounce threshold currently in effect, see smootherThreshold().
+     */
+    uint8_t getEffectiveSmootherThreshold() const {
+        return smootherThreshold(m_params, m_internals);
+    }
+
+    /**
+     * @brief Get the envelope classification, see envelope().
+     */
+    OscillatorEnvelope getEnvelope() const {
+        return envelope(m_params, m_internals);
+    }
+
+    /**
+     * @brief Get the estimated envelope growth per half period.
+     * @return The smoothed swing ratio (> 1 growing, < 1 decaying), 0 while unknown.
+     */
+    float getGrowthRate() const {
+        return static_cast<float>(m_internals.envelope.growth) / 4096.0f;
+    }
+
+    /**
+     * @brief Get the estimated damping ratio, see dampingRatio().
+     */
+    float getDampingRatio() const {
+        return dampingRatio(m_internals.envelope.growth);
+    }
+
+    /**
+     * @brief Get the estimated undamped natural frequency, see naturalFrequency().
+     * @param sampleRate Samples per time unit; the default returns cycles per sample.
+     */
+    float getNaturalFrequency(float sampleRate = 1.0f) const {
+        return naturalFrequency(m_internals.envelope.growth, m_internals.envelope.halfPeriod) * sampleRate;
+    }
+
+    /**
+     * @brief Get the graded oscillation confidence, see score().
+     * @return The current score.
+     */
+    uint16_t getScore() const {
+        return score(m_params, m_internals);
+    }
+
+    /**
+     * @brief Get the severity levels currently reached, see severity().
+     */
+    uint8_t getSeverity() const {
+        return severity(m_params, m_internals);
+    }
+
+    /**
+     * @brief Get read-only access to the internal state.
+     * @return The current internal state.
+     */
+    const OscillatorDetectorState& getState() const {
+        return m_internals;
+    }
+
+    /**
+     * @brief Get read-only access to the state of timestamped updates.
+     *
+     * The state is allocated on the first timestamped update; before that the
+     * initial state is returned.
+     */
+    const OscillatorTimingState& getTimingState() const {
+        return m_timing.get();
+    }
+
+    /**
+     * @brief Get read-only access to the state of the velocity and acceleration modes.
+     *
+     * Allocated on the first update in a derived mode, like getTimingState().
+     */
+    const OscillatorDerivativeState& getDerivativeState() const {
+        return m_derivative.get();
+    }
+
 private:
-    struct {
-        uint8_t smootherThreshold{ 5 };
-        uint8_t sensitivity{ 5 };
-    } m_params;
-
-    struct {
-        uint8_t extremaCounter{ 0 };
-        int lastDirection{ 0 };
-        int64_t minFoundPos{ std::numeric_limits<int64_t>::max() };
-        int64_t maxFoundPos{ std::numeric_limits<int64_t>::min() };
-        uint8_t minimumDebounceCounter{ 0 };
-        uint8_t maximumDebounceCounter{ 0 };
-    } m_internals;
+    // Field-wise `if (condition) state = other;` that stays a select.
+    static void selectState(bool condition, OscillatorDetectorState& state, const OscillatorDetectorState& other) {
+        state.extremaCounter = condition ? other.extremaCounter : state.extremaCounter;
+        state.lastDirection = condition ? other.lastDirection : state.lastDirection;
+        state.minFoundPos = condition ? other.minFoundPos : state.minFoundPos;
+        state.maxFoundPos = condition ? other.maxFoundPos : state.maxFoundPos;
+        state.minimumDebounceCounter = condition ? other.minimumDebounceCounter : state.minimumDebounceCounter;
+        state.maximumDebounceCounter = condition ? other.maximumDebounceCounter : state.maximumDebounceCounter;
+        state.holdOffCounter = condition ? other.holdOffCounter : state.holdOffCounter;
+        state.exitCountdown = condition ? other.exitCountdown : state.exitCountdown;
+        state.samplesSinceExtremum = condition ? other.samplesSinceExtremum : state.samplesSinceExtremum;
+        state.halfPeriod = condition ? other.halfPeriod : state.halfPeriod;
+        state.halfPeriodJitter = condition ? other.halfPeriodJitter : state.halfPeriodJitter;
+        state.envelope.lastTurnPos = condition ? other.envelope.lastTurnPos : state.envelope.lastTurnPos;
+        state.envelope.swing = condition ? other.envelope.swing : state.envelope.swing;
+        state.envelope.previousSwing = condition ? other.envelope.previousSwing : state.envelope.previousSwing;
+        state.envelope.halfPeriod = condition ? other.envelope.halfPeriod : state.envelope.halfPeriod;
+        state.envelope.growth = condition ? other.envelope.growth : state.envelope.growth;
+        state.envelope.samplesSinceTurn = condition ? other.envelope.samplesSinceTurn : state.envelope.samplesSinceTurn;
+        state.envelope.turnSpacing = condition ? other.envelope.turnSpacing : state.envelope.turnSpacing;
+        state.envelope.lastTurn = condition ? other.envelope.lastTurn : state.envelope.lastTurn;
+        state.flipRate = condition ? other.flipRate : state.flipRate;
+    }
+
+    static void selectTiming(bool condition, OscillatorTimingState& timing, const OscillatorTimingState& other) {
+        timing.lastTimestamp = condition ? other.lastTimestamp : timing.lastTimestamp;
+        timing.lastExtremumTime = condition ? other.lastExtremumTime : timing.lastExtremumTime;
+        timing.maximumDebounceStart = condition ? other.maximumDebounceStart : timing.maximumDebounceStart;
+        timing.minimumDebounceStart = condition ? other.minimumDebounceStart : timing.minimumDebounceStart;
+        timing.maximumDebounceTime = condition ? other.maximumDebounceTime : timing.maximumDebounceTime;
+        timing.minimumDebounceTime = condition ? other.minimumDebounceTime : timing.minimumDebounceTime;
+    }
+
+    // later - earlier in two's complement, defined for any pair of timestamps.
+    static int64_t since(int64_t later, int64_t earlier) {
+        return static_cast<int64_t>(static_cast<uint64_t>(later) - static_cast<uint64_t>(earlier));
+    }
+
+    // classify() with the debounce-exceeded tests supplied by the caller (sample counts or dwell time).
+    static uint8_t decide(const OscillatorDetectorState& state, int64_t position, int direction,
+                          bool maximumDebounceExceeded, bool minimumDebounceExceeded) {
+        const bool maximumFound = (state.lastDirection > 0) & (direction <= 0);
+        const bool minimumFound = (state.lastDirection < 0) & (direction >= 0);
+        const bool maximumReached = maximumFound & (state.maxFoundPos <= position);
+        const bool minimumReached = minimumFound & (state.minFoundPos >= position);
+        const bool countMaximum = maximumReached & (state.maximumDebounceCounter == 0);
+        const bool countMinimum = minimumReached & (state.minimumDebounceCounter == 0);
+        const bool reset = (maximumFound & !maximumReached & maximumDebounceExceeded) |
+                           (minimumFound & !minimumReached & minimumDebounceExceeded);
+        return actions(maximumFound, minimumFound, maximumReached, minimumReached, countMaximum, countMinimum, reset);
+    }
+
+    // Running share of samples that reverse the direction, see smootherThreshold().
+    static void trackNoise(OscillatorDetectorState& state, int direction) {
+        const bool flip = direction * state.lastDirection < 0;
+        state.flipRate = static_cast<uint16_t>(state.flipRate + (((flip << 15) - state.flipRate) >> 5));
+    }
+
+    static constexpr uint8_t actions(bool maximumFound, bool minimumFound, bool maximumReached, bool minimumReached,
+                                     bool countMaximum, bool countMinimum, bool reset) {
+        return static_cast<uint8_t>(maximumFound * OscillatorAction::MaximumFound
+                                  | minimumFound * OscillatorAction::MinimumFound
+                                  | maximumReached * OscillatorAction::MaximumReached
+                                  | minimumReached * OscillatorAction::MinimumReached
+                                  | countMaximum * OscillatorAction::CountMaximum
+                                  | countMinimum * OscillatorAction::CountMinimum
+                                  | reset * OscillatorAction::Reset);
+    }
+
+    // The classify() logic evaluated for every combination of the packed predicates.
+    static constexpr std::array<uint8_t, 1024> makeTransitions() {
+        std::array<uint8_t, 1024> table{};
+        for (unsigned index = 0; index < table.size(); ++index) {
+            const bool lastRising = index & 1;
+            const bool lastFalling = (index >> 1) & 1;
+            const bool rising = (index >> 2) & 1;
+            const bool falling = (index >> 3) & 1;
+            const bool atMaximum = (index >> 4) & 1;
+            const bool atMinimum = (index >> 5) & 1;
+            const bool maximumDebounceZero = (index >> 6) & 1;
+            const bool minimumDebounceZero = (index >> 7) & 1;
+            const bool maximumDebounceExceeded = (index >> 8) & 1;
+            const bool minimumDebounceExceeded = (index >> 9) & 1;
+
+            const bool maximumFound = lastRising && !rising;
+            const bool minimumFound = lastFalling && !falling;
+            const bool maximumReached = maximumFound && atMaximum;
+            const bool minimumReached = minimumFound && atMinimum;
+            const bool reset = (maximumFound && !maximumReached && maximumDebounceExceeded) ||
+                               (minimumFound && !minimumReached && minimumDebounceExceeded);
+            table[index] = actions(maximumFound, minimumFound, maximumReached, minimumReached,
+                                   maximumReached && maximumDebounceZero, minimumReached && minimumDebounceZero, reset);
+        }
+        return table;
+    }
+
+    static constexpr std::array<uint8_t, 1024> s_transitions = makeTransitions();
+
+    static uint32_t distance(int64_t a, int64_t b) {
+        const uint64_t difference = a > b
+            ? static_cast<uint64_t>(a) - static_cast<uint64_t>(b)
+            : static_cast<uint64_t>(b) - static_cast<uint64_t>(a);
+        return difference > std::numeric_limits<uint32_t>::max()
+            ? std::numeric_limits<uint32_t>::max() : static_cast<uint32_t>(difference);
+    }
+
+    static void recordExtremum(OscillatorDetectorState& state, bool confirmed) {
+        constexpr uint16_t maxSamples = std::numeric_limits<uint16_t>::max();
+        const uint16_t spacing = static_cast<uint16_t>(state.samplesSinceExtremum + (state.samplesSinceExtremum < maxSamples));
+        const int32_t spacingChange = static_cast<int32_t>(spacing) - static_cast<int32_t>(state.halfPeriod);
+        const int32_t jitter = state.halfPeriodJitter;
+        const int32_t nextJitter = jitter + (((spacingChange < 0 ? -spacingChange : spacingChange) - jitter) >> 2);
+
+        state.halfPeriodJitter = (confirmed & (state.halfPeriod != 0)) ? static_cast<uint16_t>(nextJitter) : state.halfPeriodJitter;
+        state.halfPeriod = confirmed ? spacing : state.halfPeriod;
+        state.samplesSinceExtremum = confirmed ? uint16_t{ 0 } : spacing;
+    }
+
+    // A turn of the opposite kind starts a new swing, unless it is a ripple of
+    // less than a quarter of the current swing. A further turn of the same kind
+    // that goes beyond the last one extends the current swing. When a swing is
+    // completed its ratio to the swing before feeds the growth estimate and its
+    // duration the half-period estimate; ratios outside [1/4, 4] come from
+    // ripples or a partial first swing and are ignored. Called at turns only.
+    static void recordTurn(OscillatorEnvelopeState& envelope, bool maximumFound, int64_t position) {
+        const int kind = maximumFound ? 1 : -1;
+        const uint32_t travelled = distance(position, envelope.lastTurnPos);
+        const bool first = envelope.lastTurn == 0;
+        const bool alternates = (kind == -envelope.lastTurn) & (travelled != 0) &
+                                (static_cast<uint64_t>(travelled) * 4 >= envelope.swing);
+        const bool extends = (kind == envelope.lastTurn) &
+                             (kind > 0 ? position > envelope.lastTurnPos : position < envelope.lastTurnPos);
+        const bool completed = alternates & (envelope.previousSwing != 0) & (envelope.swing != 0);
+
+        const float ratio = static_cast<float>(envelope.swing) / static_cast<float>(envelope.previousSwing | !completed) * 4096.0f;
+        const bool measured = completed & (ratio >= 1024.0f) & (ratio <= 16384.0f);
+        const int32_t sample = static_cast<int32_t>(measured ? ratio : 4096.0f);
+        const int32_t growth = envelope.growth;
+        const int32_t smoothed = growth == 0 ? sample : growth + ((sample - growth) >> 2);
+        const uint64_t extended = static_cast<uint64_t>(envelope.swing) + travelled;
+
+        constexpr uint16_t maxSamples = std::numeric_limits<uint16_t>::max();
+        const uint16_t elapsed = static_cast<uint16_t>(envelope.samplesSinceTurn + (envelope.samplesSinceTurn < maxSamples));
+        const uint32_t spacing = static_cast<uint32_t>(envelope.turnSpacing) << 8;
+        const uint32_t period = envelope.halfPeriod;
+        const uint32_t smoothedPeriod = period == 0 ? spacing : static_cast<uint32_t>(static_cast<int64_t>(period) + ((static_cast<int64_t>(spacing) - period) >> 2));
+        const uint32_t stretched = static_cast<uint32_t>(envelope.turnSpacing) + elapsed;
+
+        envelope.growth = measured ? static_cast<uint16_t>(smoothed) : envelope.growth;
+        envelope.halfPeriod = (measured & (spacing != 0)) ? smoothedPeriod : envelope.halfPeriod;
+        envelope.turnSpacing = alternates ? elapsed
+                             : (extends ? static_cast<uint16_t>(stretched > maxSamples ? maxSamples : stretched)
+                             : envelope.turnSpacing);
+        envelope.samplesSinceTurn = (first | alternates | extends) ? uint16_t{ 0 } : elapsed;
+        envelope.previousSwing = alternates ? envelope.swing : envelope.previousSwing;
+        envelope.swing = alternates ? travelled
+                       : (extends ? static_cast<uint32_t>(extended > std::numeric_limits<uint32_t>::max() ? std::numeric_limits<uint32_t>::max() : extended)
+                       : envelope.swing);
+        envelope.lastTurnPos = (first | alternates | extends) ? position : envelope.lastTurnPos;
+        envelope.lastTurn = static_cast<int8_t>((first | alternates) ? kind : envelope.lastTurn);
+    }
+
+    // Natural logarithm for positive normal floats, accurate to about 1e-6.
+    // Plain arithmetic on the bit pattern, so loops over channels vectorize.
+    static float logarithm(float x) {
+        const uint32_t bits = std::bit_cast<uint32_t>(x);
+        const uint32_t fraction = bits & 0x007fffffu;
+        const bool high = fraction > 0x003504f3u;                                   // mantissa > sqrt(2)
+        const float mantissa = std::bit_cast<float>(fraction | (high ? 0x3f000000u : 0x3f800000u)); // [0.707, 1.414)
+        const float s = (mantissa - 1.0f) / (mantissa + 1.0f);
+        const float s2 = s * s;
+        const float series = 2.0f * s * (1.0f + s2 * (1.0f / 3.0f + s2 * (1.0f / 5.0f + s2 * (1.0f / 7.0f + s2 * (1.0f / 9.0f)))));
+        // exponent + high as a float without an int-to-float conversion: 2^23 + n has n in its mantissa
+        const float exponent = std::bit_cast<float>(0x4b000000u | ((bits >> 23) + high)) - (8388608.0f + 127.0f);
+        return exponent * 0.69314718f + series;
+    }
+
+    // 1 / sqrt(x) for positive normal floats, three Newton steps from the bit
+    // pattern estimate; avoids the errno path of std::sqrt that blocks vectorization.
+    static float inverseSquareRoot(float x) {
+        float y = std::bit_cast<float>(0x5f375a86u - (std::bit_cast<uint32_t>(x) >> 1));
+        y = y * (1.5f - 0.5f * x * y * y);
+        y = y * (1.5f - 0.5f * x * y * y);
+        y = y * (1.5f - 0.5f * x * y * y);
+        return y;
+    }
+
+    // State of an optional mode, allocated on first use and copied along with
+    // the detector, so detectors that never use the mode pay one pointer.
+    template <typename T>
+    class Lazy {
+    public:
+        Lazy() = default;
+        Lazy(const Lazy& other) : m_value(other.m_value ? std::make_unique<T>(*other.m_value) : nullptr) {}
+        Lazy(Lazy&&) noexcept = default;
+        Lazy& operator=(const Lazy& other) {
+            m_value = other.m_value ? std::make_unique<T>(*other.m_value) : nullptr;
+            return *this;
+        }
+        Lazy& operator=(Lazy&&) noexcept = default;
+
+        const T& get() const {
+            return m_value ? *m_value : s_initial;
+        }
+
+        T& acquire() {
+            if (!m_value) {
+                m_value = std::make_unique<T>();
+            }
+            return *m_value;
+        }
+
+    private:
+        static constexpr T s_initial{};
+        std::unique_ptr<T> m_value;
+    };
+
+    OscillatorDetectorParams m_params;
+    OscillatorDetectorState m_internals;
+    Lazy<OscillatorTimingState> m_timing;   // empty until the first timestamped update
+    Lazy<OscillatorDerivativeState> m_derivative;   // empty until the first update in a derived mode
 };
+
+
+/**
+ * @brief Oscillator detector with the original full-reset behavior.
+ */
+using OscillatorDetector = BasicOscillatorDetector<>;
@@ -0,0 +1,1348 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2025, Szymon Bandel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "OscillatorDetector.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+
+/**
+ * @brief Complete state of one bank channel, the unit of bank checkpoints.
+ *
+ * The fields of OscillatorDetectorState, OscillatorTimingState and
+ * OscillatorDerivativeState as the bank stores them, without padding: 160
+ * bytes instead of 192 for the nested structs. The per-sample counters are
+ * stamps of the bank clock and the last sample time is an offset from the
+ * bank time base, so a record stays valid while its channel is quiet; see
+ * BasicOscillatorDetectorBank::restore(). Trivially copyable, so a
+ * vector of records can be written and read back as raw bytes by the same
+ * build.
+ */
+struct OscillatorChannelRecord {
+    // Detector state.
+    int64_t minFoundPos{ std::numeric_limits<int64_t>::max() };
+    int64_t maxFoundPos{ std::numeric_limits<int64_t>::min() };
+    int64_t lastTurnPos{ 0 };
+    // Timing state; default unless the bank had timestamped updates.
+    int64_t lastTimestamp{ std::numeric_limits<int64_t>::min() };  // relative to the bank time base
+    int64_t lastExtremumTime{ 0 };
+    int64_t maximumDebounceStart{ 0 };
+    int64_t minimumDebounceStart{ 0 };
+    int64_t maximumDebounceTime{ 0 };
+    int64_t minimumDebounceTime{ 0 };
+    // Derivative state; default unless the bank ran in a derived mode.
+    int64_t lastPosition{ 0 };
+    int64_t velocity{ 0 };
+    int64_t acceleration{ 0 };
+    int64_t lastDerived{ 0 };
+    int64_t lastError{ 0 };         // see BasicOscillatorDetectorBank::updateError()
+    uint32_t channel{ 0 };
+    uint32_t swing{ 0 };
+    uint32_t previousSwing{ 0 };
+    uint32_t turnHalfPeriod{ 0 };
+    uint32_t holdOffEnd{ 0 };       // clock at which the hold-off runs out
+    uint32_t extremumStamp{ 0 };    // clock - samplesSinceExtremum
+    uint32_t turnStamp{ 0 };        // clock - samplesSinceTurn
+    uint16_t exitCountdown{ 0 };
+    uint16_t halfPeriod{ 0 };
+    uint16_t halfPeriodJitter{ 0 };
+    uint16_t growth{ 0 };
+    uint16_t turnSpacing{ 0 };
+    uint16_t flipRate{ 0 };
+    uint8_t extremaCounter{ 0 };
+    int8_t lastDirection{ 0 };
+    uint8_t minimumDebounceCounter{ 0 };
+    uint8_t maximumDebounceCounter{ 0 };
+    int8_t lastTurn{ 0 };
+    uint8_t derivativeSamples{ 0 };
+    bool errorPrimed{ false };
+};
+
+
+/**
+ * @brief A set of OscillatorDetector channels updated together.
+ *
+ * The state of all channels is stored in blocks of `Lanes` channels with one
+ * array per state field (structure of arrays inside each block). update() runs
+ * the same kernel as BasicOscillatorDetector::step() on every channel, so a
+ * channel of the bank behaves exactly like a standalone detector with the same
+ * parameters. Full blocks run with a compile-time trip count. The kernel is
+ * made of selects except for the envelope bookkeeping, which runs behind a
+ * branch at turning points only: signals that reverse on most samples make
+ * that branch unpredictable and cost about 15% more per channel, which is
+ * still cheaper than running the bookkeeping on every sample. All channels
+ * share one parameter set.
+ *
+ * Usage:
+ *  - Call update(positions, directions, events) once per tick with one entry
+ *    per channel; events receives the OscillatorEvent flags of each channel.
+ *    updateError(setpoints, feedbacks, events) tracks the control error instead.
+ *  - Use getScore()/computeScores()/topK() to rank the alerting channels.
+ *  - Use snapshot()/checkpoint()/restore() to persist the channel state.
+ *  - Copy the bank to run other parameters from the live state (what-if);
+ *    the copy shares nothing with the original.
+ *
+ * @tparam ResetPolicy See OscillatorReset.
+ * @tparam Lanes Channels per block; a multiple of the SIMD width works best.
+ */
+template <typename ResetPolicy = OscillatorReset::Full, std::size_t Lanes = 16>
+class BasicOscillatorDetectorBank {
+public:
+    using Detector = BasicOscillatorDetector<ResetPolicy>;
+
+    explicit BasicOscillatorDetectorBank(std::size_t channels)
+        : m_channels(channels)
+        , m_blocks((channels + Lanes - 1) / Lanes)
+        , m_dirty((channels + 63) / 64, 0) {}
+
+    /**
+     * @brief Get the number of channels.
+     */
+    std::size_t size() const {
+        return m_channels;
+    }
+
+    /**
+     * @brief Update every channel with its current sample.
+     *
+     * In the velocity and acceleration modes every block is first differentiated
+     * into a block-local buffer, which the detection kernel then consumes while
+     * it is still in L1; see setDerivative().
+     * @param positions One signal value per channel.
+     * @param directions One direction of change per channel (-1, 0, 1); ignored, and may be nullptr, in the derived modes.
+     * @param events Receives the OscillatorEvent flags of each channel; may be nullptr.
+     * @return The flags of all channels ORed together, e.g. to test for any detection.
+     */
+    uint8_t update(const int64_t* positions, const int8_t* directions, uint8_t* events) {
+        return m_tracking ? updateBlocks<true>(positions, directions, events)
+                          : updateBlocks<false>(positions, directions, events);
+    }
+
+    /**
+     * @brief Update every channel with a timestamped sample.
+     *
+     * Debounce and detection window are measured in time, see
+     * BasicOscillatorDetector::detect(position, direction, timestamp). The
+     * timing state is allocated with the first timestamped update.
+     * @param timestamps One sample time per channel in nanoseconds.
+     */
+    uint8_t update(const int64_t* positions, const int8_t* directions, const int64_t* timestamps, uint8_t* events) {
+        return m_tracking ? updateTimedBlocks<true>(positions, directions, timestamps, events)
+                          : updateTimedBlocks<false>(positions, directions, timestamps, events);
+    }
+
+    /**
+     * @brief Update every channel with the tracking error of a control loop.
+     *
+     * The detectors track setpoint - feedback. The error of a block and its
+     * direction of change are computed into a block-local buffer that the
+     * detection kernel consumes right away, so no error frame is written to or
+     * read back from memory. The previous error of each channel is kept for the
+     * direction; the first error update of a channel reports direction 0. In the
+     * velocity and acceleration modes the error is differentiated instead.
+     * @param setpoints, feedbacks One entry per channel.
+     * @param events Receives the OscillatorEvent flags of each channel; may be nullptr.
+     * @return The flags of all channels ORed together.
+     */
+    uint8_t updateError(const int64_t* setpoints, const int64_t* feedbacks, uint8_t* events) {
+        return m_tracking ? updateErrorBlocks<true>(setpoints, feedbacks, events)
+                          : updateErrorBlocks<false>(setpoints, feedbacks, events);
+    }
+
+    /**
+     * @brief Update only the channels that reported, with timestamped samples.
+     *
+     * Channels not listed are not touched at all. A channel whose previous
+     * sample is older than staleAfter starts over before the new sample is
+     * applied (lazy expiry), see setStaleAfter().
+     * @param channels Indices of the reporting channels; each at most once.
+     * @param count Number of reports.
+     * @param positions, directions, timestamps One entry per report.
+     * @param events Receives the OscillatorEvent flags of each report; may be nullptr.
+     * @return The flags of all reports ORed together.
+     */
+    uint8_t update(const uint32_t* channels, std::size_t count, const int64_t* positions, const int8_t* directions,
+                const int64_t* timestamps, uint8_t* events) {
+        m_timing.resize(m_blocks.size());
+        const bool derived = prepareDerivatives();
+        const OscillatorDetectorParams params = m_params;
+        uint8_t any = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            const std::size_t block = channels[i] / Lanes;
+            const std::size_t lane = channels[i] % Lanes;
+            bool changed = false;
+            int64_t position = positions[i];
+            int direction = derived ? 0 : directions[i];
+            if (derived) {
+                OscillatorDerivativeState derivative = m_derivatives[block].load(lane);
+                position = Detector::derive(params, derivative, position, direction);
+                changed |= m_derivatives[block].store(lane, derivative);
+            }
+            // The clock does not advance, so the counters of the channel move its stamps.
+            OscillatorDetectorState state = m_blocks[block].load(lane, m_clock);
+            OscillatorTimingState timing = m_timing[block].load(lane, m_timeBase);
+            const uint8_t flags = Detector::stepTimed(params, state, timing, position, direction, timestamps[i]);
+            changed |= m_blocks[block].store(lane, state, m_clock);
+            changed |= m_timing[block].store(lane, timing, m_timeBase);
+            if (changed) {
+                mark(channels[i]);
+            }
+            any |= flags;
+            if (events) {
+                events[i] = flags;
+            }
+        }
+        return any;
+    }
+
+    /**
+     * @brief Reset, in bulk, every channel that has not reported for longer than staleAfter.
+     *
+     * The last sample times of a block are compared with the cutoff four at a
+     * time (AVX2); blocks without a stale channel are skipped and only the
+     * expired channels are written. Expired channels are back in the initial
+     * state, so they are not visited again until they report. Channels that
+     * never had a timestamped update are left alone.
+     * @param now Current time in nanoseconds.
+     * @return The number of channels reset.
+     */
+    std::size_t expire(int64_t now) {
+        if (m_params.staleAfter <= 0) {
+            return 0;
+        }
+        // The stored sample times are offsets, so the cutoff is moved to the time base.
+        const int64_t cutoff = offset(now - m_params.staleAfter, m_timeBase, false);
+        std::size_t expired = 0;
+#if defined(__AVX2__)
+        const __m256i limit = _mm256_set1_epi64x(cutoff);
+        const __m256i never = _mm256_set1_epi64x(std::numeric_limits<int64_t>::min());
+#endif
+        for (std::size_t b = 0; b < m_timing.size(); ++b) {
+            const TimingBlock& timing = m_timing[b];
+            std::size_t lane = 0;
+#if defined(__AVX2__)
+            // Most blocks hold no stale channel; skip them after a vector test.
+            __m256i stale = _mm256_setzero_si256();
+            for (; lane + 4 <= Lanes; lane += 4) {
+                const __m256i last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(timing.lastTimestamp + lane));
+                stale = _mm256_or_si256(stale, _mm256_and_si256(_mm256_cmpgt_epi64(limit, last), _mm256_cmpgt_epi64(last, never)));
+            }
+            if (_mm256_testz_si256(stale, stale) && lane == Lanes) {
+                continue;
+            }
+            lane = 0;
+#endif
+            for (; lane < Lanes; ++lane) {
+                const int64_t last = timing.lastTimestamp[lane];
+                if (last != std::numeric_limits<int64_t>::min() && last < cutoff) {
+                    expireLane(b, lane);
+                    mark(b * Lanes + lane);
+                    ++expired;
+                }
+            }
+        }
+        return expired;
+    }
+
+    /**
+     * @brief Reset every channel to the initial state.
+     */
+    void reset() {
+        std::fill(m_blocks.begin(), m_blocks.end(), Block{});
+        std::fill(m_timing.begin(), m_timing.end(), TimingBlock{});
+        std::fill(m_derivatives.begin(), m_derivatives.end(), DerivativeBlock{});
+        std::fill(m_errors.begin(), m_errors.end(), ErrorBlock{});
+        m_clock = 0;
+        m_timeBase = 0;
+        markAll();
+    }
+
+    /**
+     * @brief Write the state of every channel and start tracking changes anew.
+     *
+     * The records are in channel order, so `base[channel]` is the record of a
+     * channel; see compact(). The first snapshot() or checkpoint() switches the
+     * change tracking on, see checkpoint().
+     * @param out Receives one record per channel (replaced).
+     */
+    void snapshot(std::vector<OscillatorChannelRecord>& out) {
+        out.resize(m_channels);
+        for (std::size_t channel = 0; channel < m_channels; ++channel) {
+            out[channel] = record(channel);
+        }
+        std::fill(m_dirty.begin(), m_dirty.end(), 0);
+        m_tracking = true;
+    }
+
+    /**
+     * @brief Write only the channels updated since the last snapshot() or checkpoint().
+     *
+     * Change tracking is opt-in: it starts with the first snapshot() or
+     * checkpoint(), and the first checkpoint() without a snapshot writes every
+     * channel. From then on every update marks the channels whose stored state
+     * it changed in a dirty bitmap, and expire() marks the expired ones. The
+     * per-sample counters are stored as stamps of a clock that advances with
+     * every dense update, and sample times as offsets from the time base of the
+     * latest dense update, so a channel that is fed without an event or a
+     * change of direction usually stays clean. The bitmap is scanned a word at
+     * a time, so a checkpoint costs O(channels / 64) plus the records written.
+     * @param out Receives the records of the dirty channels, in channel order (appended).
+     * @return The number of records written.
+     */
+    std::size_t checkpoint(std::vector<OscillatorChannelRecord>& out) {
+        if (!m_tracking) {
+            markAll();
+            m_tracking = true;
+        }
+        const std::size_t first = out.size();
+        out.reserve(first + dirtyCount());
+        for (std::size_t word = 0; word < m_dirty.size(); ++word) {
+            for (uint64_t bits = m_dirty[word]; bits != 0; bits &= bits - 1) {
+                out.push_back(record(word * 64 + static_cast<std::size_t>(std::countr_zero(bits))));
+            }
+            m_dirty[word] = 0;
+        }
+        return out.size() - first;
+    }
+
+    /**
+     * @brief Load channel states from a snapshot or checkpoint.
+     *
+     * To restore a bank, restore the base snapshot and then every later
+     * checkpoint in order, or a base that compact() has brought up to date.
+     * Restored channels are marked dirty.
+     * @param clock The getClock() value saved with the last of the records;
+     *              it becomes the clock of this bank.
+     * @param timeBase The getTimeBase() value saved with it; only matters for
+     *                 timestamped banks.
+     */
+    void restore(const OscillatorChannelRecord* records, std::size_t count, uint32_t clock, int64_t timeBase = 0) {
+        m_clock = clock;
+        m_timeBase = timeBase;
+        for (std::size_t i = 0; i < count; ++i) {
+            const OscillatorChannelRecord& record = records[i];
+            const std::size_t block = record.channel / Lanes;
+            const std::size_t lane = record.channel % Lanes;
+            m_blocks[block].store(lane, recordState(record, clock), clock);
+            if (!m_timing.empty() || record.lastTimestamp != OscillatorTimingState{}.lastTimestamp) {
+                m_timing.resize(m_blocks.size());
+                m_timing[block].store(lane, recordTiming(record), 0);
+            }
+            if (!m_derivatives.empty() || record.derivativeSamples != 0) {
+                m_derivatives.resize(m_blocks.size());
+                m_derivatives[block].store(lane, recordDerivative(record));
+            }
+            if (!m_errors.empty() || record.errorPrimed) {
+                m_errors.resize(m_blocks.size());
+                m_errors[block].lastError[lane] = record.lastError;
+                m_errors[block].primed[lane] = record.errorPrimed;
+            }
+            mark(record.channel);
+        }
+    }
+
+    /**
+     * @brief Fold a checkpoint into a base snapshot, so old checkpoints can be dropped.
+     * @param base A snapshot(), one record per channel in channel order.
+     */
+    static void compact(std::vector<OscillatorChannelRecord>& base, const OscillatorChannelRecord* records,
+                        std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            base[records[i].channel] = records[i];
+        }
+    }
+
+    /**
+     * @brief Get the bank clock, the number of dense updates modulo 2^32.
+     *
+     * Records store the per-sample counters as stamps of this clock, so save it
+     * with every snapshot or checkpoint and pass it to restore().
+     */
+    uint32_t getClock() const {
+        return m_clock;
+    }
+
+    /**
+     * @brief Get the time base of the sample times in the records.
+     *
+     * The time base follows the first channel of every timestamped dense
+     * update. Records store the last sample time of a channel relative to it,
+     * so save it with the clock and pass both to restore().
+     */
+    int64_t getTimeBase() const {
+        return m_timeBase;
+    }
+
+    /**
+     * @brief Get the number of channels the next checkpoint() would write.
+     */
+    std::size_t dirtyCount() const {
+        if (!m_tracking) {
+            return m_channels;
+        }
+        std::size_t count = 0;
+        for (uint64_t bits : m_dirty) {
+            count += static_cast<std::size_t>(std::popcount(bits));
+        }
+        return count;
+    }
+
+    /**
+     * @brief Get a copy of the state of one channel.
+     */
+    OscillatorDetectorState getState(std::size_t channel) const {
+        return m_blocks[channel / Lanes].load(channel % Lanes, m_clock);
+    }
+
+    /**
+     * @brief Get the confidence score of one channel, see BasicOscillatorDetector::score().
+     */
+    uint16_t getScore(std::size_t channel) const {
+        return Detector::score(m_params, getState(channel));
+    }
+
+    /**
+     * @brief Get the envelope classification of one channel, see BasicOscillatorDetector::envelope().
+     */
+    OscillatorEnvelope getEnvelope(std::size_t channel) const {
+        return Detector::envelope(m_params, getState(channel));
+    }
+
+    /**
+     * @brief Compute damping ratio and natural frequency of every channel.
+     *
+     * Same estimates as BasicOscillatorDetector::dampingRatio() and
+     * naturalFrequency(), computed block by block straight from the state
+     * arrays so the float math runs as SIMD.
+     * @param dampingRatios Receives size() damping ratios.
+     * @param naturalFrequencies Receives size() natural frequencies.
+     * @param sampleRate Samples per time unit; 1 gives cycles per sample.
+     */
+    void computeModalEstimates(float* dampingRatios, float* naturalFrequencies, float sampleRate = 1.0f) const {
+        for (std::size_t b = 0; b < m_blocks.size(); ++b) {
+            const Block& block = m_blocks[b];
+            float zeta[Lanes];
+            float frequency[Lanes];
+            for (std::size_t lane = 0; lane < Lanes; ++lane) {
+                zeta[lane] = Detector::dampingRatio(block.growth[lane]);
+                frequency[lane] = Detector::naturalFrequency(block.growth[lane], block.turnHalfPeriod[lane]) * sampleRate;
+            }
+            const std::size_t base = b * Lanes;
+            const std::size_t lanes = std::min(Lanes, m_channels - base);
+            std::copy(zeta, zeta + lanes, dampingRatios + base);
+            std::copy(frequency, frequency + lanes, naturalFrequencies + base);
+        }
+    }
+
+    /**
+     * @brief Get the severity levels reached by one channel, see BasicOscillatorDetector::severity().
+     */
+    uint8_t getSeverity(std::size_t channel) const {
+        return Detector::severity(m_params, getState(channel));
+    }
+
+    /**
+     * @brief Compute the severity bitmask of every channel.
+     * @param severities Receives size() bitmasks.
+     */
+    void computeSeverities(uint8_t* severities) const {
+        const uint32_t clock = m_clock;
+        for (std::size_t b = 0; b < m_blocks.size(); ++b) {
+            const Block& block = m_blocks[b];
+            uint8_t masks[Lanes];
+            for (std::size_t lane = 0; lane < Lanes; ++lane) {
+                masks[lane] = Detector::severity(m_params, block.extremaCounter[lane], block.holdOffCounter(lane, clock));
+            }
+            const std::size_t base = b * Lanes;
+            std::copy(masks, masks + std::min(Lanes, m_channels - base), severities + base);
+        }
+    }
+
+    /**
+     * @brief Compute the confidence score of every channel.
+     * @param scores Receives size() scores.
+     */
+    void computeScores(uint16_t* scores) const {
+        for (std::size_t b = 0; b < m_blocks.size(); ++b) {
+            const Block& block = m_blocks[b];
+            uint16_t values[Lanes];
+            for (std::size_t lane = 0; lane < Lanes; ++lane) {
+                values[lane] = Detector::score(m_params, block.extremaCounter[lane], block.growth[lane],
+                                               block.halfPeriod[lane], block.halfPeriodJitter[lane]);
+            }
+            const std::size_t base = b * Lanes;
+            std::copy(values, values + std::min(Lanes, m_channels - base), scores + base);
+        }
+    }
+
+    /**
+     * @brief Find the k channels with the highest confidence score.
+     *
+     * Ties are broken by the lower channel index.
+     * @param k Number of channels requested.
+     * @param channels Receives min(k, size()) channel indices, best first.
+     * @return The number of indices written.
+     */
+    std::size_t topK(std::size_t k, uint32_t* channels) const {
+        m_scores.resize(m_channels);
+        computeScores(m_scores.data());
+        return selectTopK(m_scores.data(), m_channels, k, channels);
+    }
+
+    /**
+     * @brief Partial selection of the k largest scores.
+     *
+     * A 256-bin histogram of the score high bytes gives a lower bound that at
+     * least k scores reach; a SIMD compare pass collects only those candidates,
+     * and only the candidates are sorted.
+     * @return The number of indices written to `out`.
+     */
+    static std::size_t selectTopK(const uint16_t* scores, std::size_t count, std::size_t k, uint32_t* out) {
+        k = std::min(k, count);
+        if (k == 0) {
+            return 0;
+        }
+
+        std::size_t histogram[256] = {};
+        for (std::size_t i = 0; i < count; ++i) {
+            ++histogram[scores[i] >> 8];
+        }
+        std::size_t bucket = 256;
+        std::size_t above = 0;
+        while (above < k) {
+            above += histogram[--bucket];
+        }
+        const uint16_t threshold = static_cast<uint16_t>(bucket << 8);
+
+        std::vector<uint32_t> candidates;
+        candidates.reserve(above);
+        std::size_t i = 0;
+#if defined(__AVX2__)
+        const __m256i limit = _mm256_set1_epi16(static_cast<short>(threshold));
+        for (; i + 16 <= count; i += 16) {
+            // subs_epu16(limit, v) == 0  <=>  v >= limit (unsigned)
+            const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(scores + i));
+            const __m256i below = _mm256_subs_epu16(limit, values);
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(below, _mm256_setzero_si256())));
+            for (mask &= 0x55555555u; mask != 0; mask &= mask - 1) {
+                candidates.push_back(static_cast<uint32_t>(i + (std::countr_zero(mask) >> 1)));
+            }
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        const __m128i limit = _mm_set1_epi16(static_cast<short>(threshold));
+        for (; i + 8 <= count; i += 8) {
+            const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(scores + i));
+            const __m128i below = _mm_subs_epu16(limit, values);
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi16(below, _mm_setzero_si128())));
+            for (mask &= 0x5555u; mask != 0; mask &= mask - 1) {
+                candidates.push_back(static_cast<uint32_t>(i + (std::countr_zero(mask) >> 1)));
+            }
+        }
+#endif
+        for (; i < count; ++i) {
+            if (scores[i] >= threshold) {
+                candidates.push_back(static_cast<uint32_t>(i));
+            }
+        }
+
+        std::partial_sort(candidates.begin(), candidates.begin() + k, candidates.end(),
+            [scores](uint32_t a, uint32_t b) {
+                return scores[a] != scores[b] ? scores[a] > scores[b] : a < b;
+            });
+        std::copy(candidates.begin(), candidates.begin() + k, out);
+        return k;
+    }
+
+    /**
+     * @brief Set the smoothing threshold of all channels, see OscillatorDetector.
+     */
+    void setSmootherThreshold(uint8_t threshold) {
+        m_params.smootherThreshold = threshold;
+    }
+
+    /**
+     * @brief Set the sensitivity of all channels, see OscillatorDetector.
+     */
+    void setSensitivity(uint8_t sensitivity) {
+        m_params.sensitivity = sensitivity;
+    }
+
+    /**
+     * @brief Set the severity level thresholds of all channels, see OscillatorDetector.
+     */
+    void setSeverityLevels(const std::array<uint8_t, 4>& levels) {
+        m_params.severityLevels = levels;
+    }
+
+    /**
+     * @brief Set the hold-off period of all channels, see OscillatorDetector.
+     */
+    void setHoldOff(uint16_t samples) {
+        m_params.holdOff = samples;
+    }
+
+    /**
+     * @brief Set the exit hysteresis of all channels, see OscillatorDetector.
+     */
+    void setExitDelay(uint16_t samples) {
+        m_params.exitDelay = samples;
+    }
+
+    /**
+     * @brief Set the counted half period band of all channels, see OscillatorDetector.
+     */
+    void setHalfPeriodBand(uint16_t minimum, uint16_t maximum) {
+        m_params.minHalfPeriod = minimum;
+        m_params.maxHalfPeriod = maximum;
+    }
+
+    /**
+     * @brief Track the velocity or acceleration of every channel, see OscillatorDetector.
+     *
+     * A smoothing above 62 is clamped to 62.
+     */
+    void setDerivative(OscillatorDerivative derivative, uint8_t smoothing = 0) {
+        m_params.derivative = derivative;
+        m_params.derivativeSmoothing = std::min(smoothing, uint8_t{ 62 });
+    }
+
+    /**
+     * @brief Set the debounce dwell of timestamped updates of all channels, see OscillatorDetector.
+     */
+    void setSmootherTime(int64_t nanoseconds) {
+        m_params.smootherTime = nanoseconds;
+    }
+
+    /**
+     * @brief Set the detection window of timestamped updates of all channels, see OscillatorDetector.
+     */
+    void setDetectionWindow(int64_t nanoseconds) {
+        m_params.detectionWindow = nanoseconds;
+    }
+
+    /**
+     * @brief Set the gap after which a channel is expired, see expire() and OscillatorDetector.
+     */
+    void setStaleAfter(int64_t nanoseconds) {
+        m_params.staleAfter = nanoseconds;
+    }
+
+    /**
+     * @brief Set the steady-envelope tolerance of all channels, see OscillatorDetector.
+     */
+    void setEnvelopeTolerance(uint16_t tolerance) {
+        m_params.envelopeTolerance = tolerance;
+    }
+
+    /**
+     * @brief Set the adaptive threshold gain of all channels, see OscillatorDetector.
+     */
+    void setNoiseGain(uint8_t gain) {
+        m_params.noiseGain = gain;
+    }
+
+    /**
+     * @brief Get the current smoothing threshold.
+     */
+    uint8_t getSmootherThreshold() const {
+        return m_params.smootherThreshold;
+    }
+
+    /**
+     * @brief Get the current sensitivity threshold.
+     */
+    uint8_t getSensitivity() const {
+        return m_params.sensitivity;
+    }
+
+    /**
+     * @brief Get the severity level thresholds.
+     */
+    const std::array<uint8_t, 4>& getSeverityLevels() const {
+        return m_params.severityLevels;
+    }
+
+    /**
+     * @brief Get the current hold-off period.
+     */
+    uint16_t getHoldOff() const {
+        return m_params.holdOff;
+    }
+
+    /**
+     * @brief Get the exit hysteresis in quiet updates.
+     */
+    uint16_t getExitDelay() const {
+        return m_params.exitDelay;
+    }
+
+    /**
+     * @brief Get the shortest counted half period in samples.
+     */
+    uint16_t getMinHalfPeriod() const {
+        return m_params.minHalfPeriod;
+    }
+
+    /**
+     * @brief Get the longest counted half period in samples.
+     */
+    uint16_t getMaxHalfPeriod() const {
+        return m_params.maxHalfPeriod;
+    }
+
+    /**
+     * @brief Get the tracked signal.
+     */
+    OscillatorDerivative getDerivative() const {
+        return m_params.derivative;
+    }
+
+    /**
+     * @brief Get the EMA weight exponent of the derived modes.
+     */
+    uint8_t getDerivativeSmoothing() const {
+        return m_params.derivativeSmoothing;
+    }
+
+    /**
+     * @brief Get the debounce dwell of timestamped updates (ns).
+     */
+    int64_t getSmootherTime() const {
+        return m_params.smootherTime;
+    }
+
+    /**
+     * @brief Get the detection window of timestamped updates (ns, 0 = unlimited).
+     */
+    int64_t getDetectionWindow() const {
+        return m_params.detectionWindow;
+    }
+
+    /**
+     * @brief Get the gap after which a channel is expired (ns, 0 = never).
+     */
+    int64_t getStaleAfter() const {
+        return m_params.staleAfter;
+    }
+
+    /**
+     * @brief Get the current steady-envelope tolerance (Q12).
+     */
+    uint16_t getEnvelopeTolerance() const {
+        return m_params.envelopeTolerance;
+    }
+
+    /**
+     * @brief Get the adaptive threshold gain (0 = fixed threshold).
+     */
+    uint8_t getNoiseGain() const {
+        return m_params.noiseGain;
+    }
+
+private:
+    // Per-sample counters are stored as stamps of the bank clock, which advances
+    // once per dense update: a counter that only advanced with the clock leaves
+    // its stamp, and so the stored state of a quiet channel, unchanged.
+    static uint16_t elapsed(uint32_t stamp, uint32_t clock) {
+        const uint32_t ticks = clock - stamp;
+        return static_cast<uint16_t>(ticks < 65535u ? ticks : 65535u);   // saturating, like the counters
+    }
+
+    static uint16_t remaining(uint32_t end, uint32_t clock) {
+        const uint32_t ticks = end - clock;
+        return static_cast<uint16_t>(ticks <= 65535u ? ticks : 0u);     // an end in the past wraps high
+    }
+
+    // The stamps are re-anchored long before the 32-bit clock could wrap past them.
+    static uint32_t sinceStamp(uint32_t stamp, uint32_t clock, uint16_t samples) {
+        const bool keep = (elapsed(stamp, clock) == samples) & (clock - stamp < (1u << 30));
+        return keep ? stamp : clock - samples;
+    }
+
+    static uint32_t endStamp(uint32_t end, uint32_t clock, uint16_t samples) {
+        const bool keep = (remaining(end, clock) == samples) & ((end - clock <= 65535u) | (clock - end < (1u << 30)));
+        return keep ? end : clock + samples;
+    }
+
+    // Sample times in the same spirit: the last sample time of a channel is kept
+    // relative to the time base of the latest dense update, so a channel sampled
+    // on the common tick keeps its stored offset. Wrapping arithmetic; the
+    // "no sample yet" marker passes through unchanged.
+    static int64_t offset(int64_t time, int64_t timeBase, bool toAbsolute) {
+        const uint64_t base = static_cast<uint64_t>(timeBase);
+        const uint64_t moved = toAbsolute ? static_cast<uint64_t>(time) + base : static_cast<uint64_t>(time) - base;
+        return time == std::numeric_limits<int64_t>::min() ? time : static_cast<int64_t>(moved);
+    }
+
+    // Bodies of the dense updates. Without Track the compare results are unused,
+    // so the compiler drops them and the stores are plain writes.
+    template <bool Track>
+    uint8_t updateBlocks(const int64_t* positions, const int8_t* directions, uint8_t* events) {
+        const bool derived = prepareDerivatives();
+        uint8_t any = 0;
+        for (std::size_t b = 0; b < m_blocks.size(); ++b) {
+            const std::size_t base = b * Lanes;
+            const std::size_t lanes = std::min(Lanes, m_channels - base);
+            Block& block = m_blocks[b];
+            uint8_t changed[Lanes]{};
+            const int64_t* input = positions + base;
+            const int8_t* inputDirections = derived ? nullptr : directions + base;
+            int64_t values[Lanes];
+            int8_t valueDirections[Lanes];
+            if (derived && lanes == Lanes) {
+                deriveLanes<Lanes, Track>(m_derivatives[b], input, values, valueDirections, changed, Lanes);
+                input = values;
+                inputDirections = valueDirections;
+            }
+            else if (derived) {
+                deriveLanes<1, Track>(m_derivatives[b], input, values, valueDirections, changed, lanes);
+                input = values;
+                inputDirections = valueDirections;
+            }
+            uint8_t flags[Lanes];
+            if (lanes == Lanes) {
+                updateLanes<Lanes, Track>(block, input, inputDirections, flags, changed, Lanes);
+            }
+            else {
+                updateLanes<1, Track>(block, input, inputDirections, flags, changed, lanes); // scalar tail
+            }
+            for (std::size_t lane = 0; lane < lanes; ++lane) {
+                any |= flags[lane];
+            }
+            if (events) {
+                std::copy(flags, flags + lanes, events + base);
+            }
+            if constexpr (Track) {
+                markChanged(base, changed, lanes);
+            }
+        }
+        ++m_clock;
+        return any;
+    }
+
+    template <bool Track>
+    uint8_t updateTimedBlocks(const int64_t* positions, const int8_t* directions, const int64_t* timestamps, uint8_t* events) {
+        m_timing.resize(m_blocks.size());
+        const bool derived = prepareDerivatives();
+        // The stored sample times are offsets from a time base that follows the
+        // first channel, so a bank sampled on a common tick keeps them constant.
+        const int64_t timeBase = m_channels == 0 ? m_timeBase : timestamps[0];
+        uint8_t any = 0;
+        for (std::size_t b = 0; b < m_blocks.size(); ++b) {
+            const std::size_t base = b * Lanes;
+            const std::size_t lanes = std::min(Lanes, m_channels - base);
+            uint8_t changed[Lanes]{};
+            const int64_t* input = positions + base;
+            const int8_t* inputDirections = derived ? nullptr : directions + base;
+            int64_t values[Lanes];
+            int8_t valueDirections[Lanes];
+            if (derived && lanes == Lanes) {
+                deriveLanes<Lanes, Track>(m_derivatives[b], input, values, valueDirections, changed, Lanes);
+                input = values;
+                inputDirections = valueDirections;
+            }
+            else if (derived) {
+                deriveLanes<1, Track>(m_derivatives[b], input, values, valueDirections, changed, lanes);
+                input = values;
+                inputDirections = valueDirections;
+            }
+            uint8_t flags[Lanes];
+            if (lanes == Lanes) {
+                updateTimedLanes<Lanes, Track>(m_blocks[b], m_timing[b], input, inputDirections, timestamps + base, timeBase, flags, changed, Lanes);
+            }
+            else {
+                updateTimedLanes<1, Track>(m_blocks[b], m_timing[b], input, inputDirections, timestamps + base, timeBase, flags, changed, lanes);
+            }
+            for (std::size_t lane = 0; lane < lanes; ++lane) {
+                any |= flags[lane];
+            }
+            if (events) {
+                std::copy(flags, flags + lanes, events + base);
+            }
+            if constexpr (Track) {
+                markChanged(base, changed, lanes);
+            }
+        }
+        ++m_clock;
+        m_timeBase = timeBase;
+        return any;
+    }
+
+    template <bool Track>
+    uint8_t updateErrorBlocks(const int64_t* setpoints, const int64_t* feedbacks, uint8_t* events) {
+        m_errors.resize(m_blocks.size());
+        const bool derived = prepareDerivatives();
+        uint8_t any = 0;
+        for (std::size_t b = 0; b < m_blocks.size(); ++b) {
+            const std::size_t base = b * Lanes;
+            const std::size_t lanes = std::min(Lanes, m_channels - base);
+            uint8_t changed[Lanes]{};
+            int64_t errors[Lanes];
+            int8_t errorDirections[Lanes];
+            int64_t values[Lanes];
+            int8_t valueDirections[Lanes];
+            const int64_t* input = errors;
+            const int8_t* inputDirections = errorDirections;
+            uint8_t flags[Lanes];
+            if (lanes == Lanes) {
+                errorLanes<Lanes, Track>(m_errors[b], setpoints + base, feedbacks + base, errors, errorDirections, changed, Lanes);
+                if (derived) {
+                    deriveLanes<Lanes, Track>(m_derivatives[b], errors, values, valueDirections, changed, Lanes);
+                    input = values;
+                    inputDirections = valueDirections;
+                }
+                updateLanes<Lanes, Track>(m_blocks[b], input, inputDirections, flags, changed, Lanes);
+            }
+            else {
+                errorLanes<1, Track>(m_errors[b], setpoints + base, feedbacks + base, errors, errorDirections, changed, lanes);
+                if (derived) {
+                    deriveLanes<1, Track>(m_derivatives[b], errors, values, valueDirections, changed, lanes);
+                    input = values;
+                    inputDirections = valueDirections;
+                }
+                updateLanes<1, Track>(m_blocks[b], input, inputDirections, flags, changed, lanes);
+            }
+            for (std::size_t lane = 0; lane < lanes; ++lane) {
+                any |= flags[lane];
+            }
+            if (events) {
+                std::copy(flags, flags + lanes, events + base);
+            }
+            if constexpr (Track) {
+                markChanged(base, changed, lanes);
+            }
+        }
+        ++m_clock;
+        return any;
+    }
+
+    // Writes a field and reports whether its value changed; without Track it only writes.
+    template <bool Track = true, typename T, typename U>
+    static bool assign(T& field, U value) {
+        const T next = static_cast<T>(value);
+        const bool changed = Track && field != next;
+        field = next;
+        return changed;
+    }
+
+    struct Block {
+        int64_t minFoundPos[Lanes]{};
+        int64_t maxFoundPos[Lanes]{};
+        int64_t lastTurnPos[Lanes]{};
+        uint32_t swing[Lanes]{};
+        uint32_t previousSwing[Lanes]{};
+        uint32_t turnHalfPeriod[Lanes]{};
+        uint32_t holdOffEnd[Lanes]{};     // clock at which the hold-off runs out
+        uint32_t extremumStamp[Lanes]{};  // clock - samplesSinceExtremum
+        uint32_t turnStamp[Lanes]{};      // clock - samplesSinceTurn
+        uint16_t exitCountdown[Lanes]{};
+        uint16_t halfPeriod[Lanes]{};
+        uint16_t halfPeriodJitter[Lanes]{};
+        uint16_t growth[Lanes]{};
+        uint16_t turnSpacing[Lanes]{};
+        uint16_t flipRate[Lanes]{};
+        uint8_t extremaCounter[Lanes]{};
+        int8_t lastDirection[Lanes]{};
+        uint8_t minimumDebounceCounter[Lanes]{};
+        uint8_t maximumDebounceCounter[Lanes]{};
+        int8_t lastTurn[Lanes]{};
+
+        Block() {
+            for (std::size_t lane = 0; lane < Lanes; ++lane) {
+                store(lane, OscillatorDetectorState{}, 0);
+            }
+        }
+
+        uint16_t holdOffCounter(std::size_t lane, uint32_t clock) const {
+            return remaining(holdOffEnd[lane], clock);
+        }
+
+        OscillatorDetectorState load(std::size_t lane, uint32_t clock) const {
+            OscillatorDetectorState state;
+            state.extremaCounter = extremaCounter[lane];
+            state.lastDirection = lastDirection[lane];
+            state.minFoundPos = minFoundPos[lane];
+            state.maxFoundPos = maxFoundPos[lane];
+            state.minimumDebounceCounter = minimumDebounceCounter[lane];
+            state.maximumDebounceCounter = maximumDebounceCounter[lane];
+            state.holdOffCounter = remaining(holdOffEnd[lane], clock);
+            state.exitCountdown = exitCountdown[lane];
+            state.samplesSinceExtremum = elapsed(extremumStamp[lane], clock);
+            state.halfPeriod = halfPeriod[lane];
+            state.halfPeriodJitter = halfPeriodJitter[lane];
+            state.envelope.lastTurnPos = lastTurnPos[lane];
+            state.envelope.swing = swing[lane];
+            state.envelope.previousSwing = previousSwing[lane];
+            state.envelope.halfPeriod = turnHalfPeriod[lane];
+            state.envelope.growth = growth[lane];
+            state.envelope.samplesSinceTurn = elapsed(turnStamp[lane], clock);
+            state.envelope.turnSpacing = turnSpacing[lane];
+            state.flipRate = flipRate[lane];
+            state.envelope.lastTurn = lastTurn[lane];
+            return state;
+        }
+
+        // Returns whether the stored state of the lane changed; always false without Track.
+        template <bool Track = true>
+        bool store(std::size_t lane, const OscillatorDetectorState& state, uint32_t clock) {
+            return assign<Track>(extremaCounter[lane], state.extremaCounter)
+                 | assign<Track>(lastDirection[lane], state.lastDirection)
+                 | assign<Track>(minFoundPos[lane], state.minFoundPos)
+                 | assign<Track>(maxFoundPos[lane], state.maxFoundPos)
+                 | assign<Track>(minimumDebounceCounter[lane], state.minimumDebounceCounter)
+                 | assign<Track>(maximumDebounceCounter[lane], state.maximumDebounceCounter)
+                 | assign<Track>(holdOffEnd[lane], endStamp(holdOffEnd[lane], clock, state.holdOffCounter))
+                 | assign<Track>(exitCountdown[lane], state.exitCountdown)
+                 | assign<Track>(extremumStamp[lane], sinceStamp(extremumStamp[lane], clock, state.samplesSinceExtremum))
+                 | assign<Track>(halfPeriod[lane], state.halfPeriod)
+                 | assign<Track>(halfPeriodJitter[lane], state.halfPeriodJitter)
+                 | assign<Track>(lastTurnPos[lane], state.envelope.lastTurnPos)
+                 | assign<Track>(swing[lane], state.envelope.swing)
+                 | assign<Track>(previousSwing[lane], state.envelope.previousSwing)
+                 | assign<Track>(turnHalfPeriod[lane], state.envelope.halfPeriod)
+                 | assign<Track>(growth[lane], state.envelope.growth)
+                 | assign<Track>(turnStamp[lane], sinceStamp(turnStamp[lane], clock, state.envelope.samplesSinceTurn))
+                 | assign<Track>(turnSpacing[lane], state.envelope.turnSpacing)
+                 | assign<Track>(flipRate[lane], state.flipRate)
+                 | assign<Track>(lastTurn[lane], state.envelope.lastTurn);
+        }
+    };
+
+    // lastTimestamp is stored as an offset from the bank time base, see offset().
+    struct TimingBlock {
+        int64_t lastTimestamp[Lanes]{};
+        int64_t lastExtremumTime[Lanes]{};
+        int64_t maximumDebounceStart[Lanes]{};
+        int64_t minimumDebounceStart[Lanes]{};
+        int64_t maximumDebounceTime[Lanes]{};
+        int64_t minimumDebounceTime[Lanes]{};
+
+        TimingBlock() {
+            for (std::size_t lane = 0; lane < Lanes; ++lane) {
+                store(lane, OscillatorTimingState{}, 0);
+            }
+        }
+
+        OscillatorTimingState load(std::size_t lane, int64_t timeBase) const {
+            OscillatorTimingState timing;
+            timing.lastTimestamp = offset(lastTimestamp[lane], timeBase, true);
+            timing.lastExtremumTime = lastExtremumTime[lane];
+            timing.maximumDebounceStart = maximumDebounceStart[lane];
+            timing.minimumDebounceStart = minimumDebounceStart[lane];
+            timing.maximumDebounceTime = maximumDebounceTime[lane];
+            timing.minimumDebounceTime = minimumDebounceTime[lane];
+            return timing;
+        }
+
+        template <bool Track = true>
+        bool store(std::size_t lane, const OscillatorTimingState& timing, int64_t timeBase) {
+            return assign<Track>(lastTimestamp[lane], offset(timing.lastTimestamp, timeBase, false))
+                 | assign<Track>(lastExtremumTime[lane], timing.lastExtremumTime)
+                 | assign<Track>(maximumDebounceStart[lane], timing.maximumDebounceStart)
+                 | assign<Track>(minimumDebounceStart[lane], timing.minimumDebounceStart)
+                 | assign<Track>(maximumDebounceTime[lane], timing.maximumDebounceTime)
+                 | assign<Track>(minimumDebounceTime[lane], timing.minimumDebounceTime);
+        }
+    };
+
+    struct DerivativeBlock {
+        int64_t lastPosition[Lanes]{};
+        int64_t velocity[Lanes]{};
+        int64_t acceleration[Lanes]{};
+        int64_t lastDerived[Lanes]{};
+        uint8_t samples[Lanes]{};
+
+        DerivativeBlock() {
+            for (std::size_t lane = 0; lane < Lanes; ++lane) {
+                store(lane, OscillatorDerivativeState{});
+            }
+        }
+
+        OscillatorDerivativeState load(std::size_t lane) const {
+            OscillatorDerivativeState state;
+            state.lastPosition = lastPosition[lane];
+            state.velocity = velocity[lane];
+            state.acceleration = acceleration[lane];
+            state.lastDerived = lastDerived[lane];
+            state.samples = samples[lane];
+            return state;
+        }
+
+        template <bool Track = true>
+        bool store(std::size_t lane, const OscillatorDerivativeState& state) {
+            return assign<Track>(lastPosition[lane], state.lastPosition)
+                 | assign<Track>(velocity[lane], state.velocity)
+                 | assign<Track>(acceleration[lane], state.acceleration)
+                 | assign<Track>(lastDerived[lane], state.lastDerived)
+                 | assign<Track>(samples[lane], state.samples);
+        }
+    };
+
+    // Previous tracking error per channel, for the direction of updateError().
+    struct ErrorBlock {
+        int64_t lastError[Lanes]{};
+        uint8_t primed[Lanes]{};
+    };
+
+    void mark(std::size_t channel) {
+        m_dirty[channel / 64] |= uint64_t{ 1 } << (channel % 64);
+    }
+
+    void markChanged(std::size_t base, const uint8_t* changed, std::size_t lanes) {
+        for (std::size_t lane = 0; lane < lanes; ++lane) {
+            const std::size_t channel = base + lane;
+            m_dirty[channel / 64] |= uint64_t{ changed[lane] } << (channel % 64);
+        }
+    }
+
+    void markAll() {
+        std::fill(m_dirty.begin(), m_dirty.end(), ~uint64_t{ 0 });
+        if (m_channels % 64 != 0) {
+            m_dirty.back() = (uint64_t{ 1 } << (m_channels % 64)) - 1;
+        }
+    }
+
+    OscillatorChannelRecord record(std::size_t channel) const {
+        const std::size_t block = channel / Lanes;
+        const std::size_t lane = channel % Lanes;
+        const OscillatorDetectorState state = m_blocks[block].load(lane, m_clock);
+        // The sample time stays an offset from the time base, like the stamps stay relative to the clock.
+        const OscillatorTimingState timing = m_timing.empty() ? OscillatorTimingState{} : m_timing[block].load(lane, 0);
+        const OscillatorDerivativeState derivative = m_derivatives.empty() ? OscillatorDerivativeState{} : m_derivatives[block].load(lane);
+        OscillatorChannelRecord record;
+        record.minFoundPos = state.minFoundPos;
+        record.maxFoundPos = state.maxFoundPos;
+        record.lastTurnPos = state.envelope.lastTurnPos;
+        record.lastTimestamp = timing.lastTimestamp;
+        record.lastExtremumTime = timing.lastExtremumTime;
+        record.maximumDebounceStart = timing.maximumDebounceStart;
+        record.minimumDebounceStart = timing.minimumDebounceStart;
+        record.maximumDebounceTime = timing.maximumDebounceTime;
+        record.minimumDebounceTime = timing.minimumDebounceTime;
+        record.lastPosition = derivative.lastPosition;
+        record.velocity = derivative.velocity;
+        record.acceleration = derivative.acceleration;
+        record.lastDerived = derivative.lastDerived;
+        record.lastError = m_errors.empty() ? 0 : m_errors[block].lastError[lane];
+        record.channel = static_cast<uint32_t>(channel);
+        record.swing = state.envelope.swing;
+        record.previousSwing = state.envelope.previousSwing;
+        record.turnHalfPeriod = state.envelope.halfPeriod;
+        record.holdOffEnd = m_blocks[block].holdOffEnd[lane];
+        record.extremumStamp = m_blocks[block].extremumStamp[lane];
+        record.turnStamp = m_blocks[block].turnStamp[lane];
+        record.exitCountdown = state.exitCountdown;
+        record.halfPeriod = state.halfPeriod;
+        record.halfPeriodJitter = state.halfPeriodJitter;
+        record.growth = state.envelope.growth;
+        record.turnSpacing = state.envelope.turnSpacing;
+        record.flipRate = state.flipRate;
+        record.extremaCounter = state.extremaCounter;
+        record.lastDirection = static_cast<int8_t>(state.lastDirection);
+        record.minimumDebounceCounter = state.minimumDebounceCounter;
+        record.maximumDebounceCounter = state.maximumDebounceCounter;
+        record.lastTurn = state.envelope.lastTurn;
+        record.derivativeSamples = derivative.samples;
+        record.errorPrimed = !m_errors.empty() && m_errors[block].primed[lane] != 0;
+        return record;
+    }
+
+    static OscillatorDetectorState recordState(const OscillatorChannelRecord& record, uint32_t clock) {
+        OscillatorDetectorState state;
+        state.extremaCounter = record.extremaCounter;
+        state.lastDirection = record.lastDirection;
+        state.minFoundPos = record.minFoundPos;
+        state.maxFoundPos = record.maxFoundPos;
+        state.minimumDebounceCounter = record.minimumDebounceCounter;
+        state.maximumDebounceCounter = record.maximumDebounceCounter;
+        state.holdOffCounter = remaining(record.holdOffEnd, clock);
+        state.exitCountdown = record.exitCountdown;
+        state.samplesSinceExtremum = elapsed(record.extremumStamp, clock);
+        state.halfPeriod = record.halfPeriod;
+        state.halfPeriodJitter = record.halfPeriodJitter;
+        state.envelope.lastTurnPos = record.lastTurnPos;
+        state.envelope.swing = record.swing;
+        state.envelope.previousSwing = record.previousSwing;
+        state.envelope.halfPeriod = record.turnHalfPeriod;
+        state.envelope.growth = record.growth;
+        state.envelope.samplesSinceTurn = elapsed(record.turnStamp, clock);
+        state.envelope.turnSpacing = record.turnSpacing;
+        state.envelope.lastTurn = record.lastTurn;
+        state.flipRate = record.flipRate;
+        return state;
+    }
+
+    static OscillatorTimingState recordTiming(const OscillatorChannelRecord& record) {
+        return { record.lastTimestamp, record.lastExtremumTime, record.maximumDebounceStart, record.minimumDebounceStart,
+                 record.maximumDebounceTime, record.minimumDebounceTime };
+    }
+
+    static OscillatorDerivativeState recordDerivative(const OscillatorChannelRecord& record) {
+        return { record.lastPosition, record.velocity, record.acceleration, record.lastDerived, record.derivativeSamples };
+    }
+
+    void expireLane(std::size_t block, std::size_t lane) {
+        m_blocks[block].store(lane, OscillatorDetectorState{}, m_clock);
+        m_timing[block].store(lane, OscillatorTimingState{}, m_timeBase);
+        if (!m_derivatives.empty()) {
+            m_derivatives[block].store(lane, OscillatorDerivativeState{});
+        }
+        if (!m_errors.empty()) {
+            m_errors[block].lastError[lane] = 0;
+            m_errors[block].primed[lane] = 0;
+        }
+    }
+
+    // Allocates the derivative state with the first update in a derived mode.
+    bool prepareDerivatives() {
+        const bool derived = m_params.derivative != OscillatorDerivative::Position;
+        if (derived) {
+            m_derivatives.resize(m_blocks.size());
+        }
+        return derived;
+    }
+
+    // Same Width convention as updateLanes(). The input is copied first so the
+    // lane loop provably does not alias the block and vectorizes without versioning.
+    template <std::size_t Width, bool Track>
+    void deriveLanes(DerivativeBlock& block, const int64_t* positions, int64_t* values, int8_t* directions,
+                     uint8_t* changed, std::size_t lanes) const {
+        const OscillatorDetectorParams params = m_params;
+        const std::size_t count = Width == 1 ? lanes : Width;
+        int64_t input[Lanes];
+        std::copy(positions, positions + count, input);
+        for (std::size_t lane = 0; lane < count; ++lane) {
+            OscillatorDerivativeState state = block.load(lane);
+            int direction = 0;
+            values[lane] = Detector::derive(params, state, input[lane], direction);
+            directions[lane] = static_cast<int8_t>(direction);
+            const bool stored = block.template store<Track>(lane, state);
+            if constexpr (Track) {
+                changed[lane] |= stored;
+            }
+        }
+    }
+
+    // Same Width convention as updateLanes(); the inputs are copied first, as in deriveLanes().
+    template <std::size_t Width, bool Track>
+    static void errorLanes(ErrorBlock& block, const int64_t* setpoints, const int64_t* feedbacks, int64_t* errors,
+                           int8_t* directions, uint8_t* changed, std::size_t lanes) {
+        const std::size_t count = Width == 1 ? lanes : Width;
+        int64_t setpoint[Lanes];
+        int64_t feedback[Lanes];
+        std::copy(setpoints, setpoints + count, setpoint);
+        std::copy(feedbacks, feedbacks + count, feedback);
+        for (std::size_t lane = 0; lane < count; ++lane) {
+            const int64_t error = setpoint[lane] - feedback[lane];
+            const int64_t delta = error - block.lastError[lane];
+            const int direction = (delta > 0) - (delta < 0);
+            directions[lane] = static_cast<int8_t>(block.primed[lane] ? direction : 0);
+            errors[lane] = error;
+            const bool stored = assign<Track>(block.lastError[lane], error) | assign<Track>(block.primed[lane], 1);
+            if constexpr (Track) {
+                changed[lane] = static_cast<uint8_t>(changed[lane] | stored);
+            }
+        }
+    }
+
+    // The sample times load against the current time base and store against the next one.
+    template <std::size_t Width, bool Track>
+    void updateTimedLanes(Block& block, TimingBlock& timingBlock, const int64_t* positions, const int8_t* directions,
+                          const int64_t* timestamps, int64_t timeBase, uint8_t* flags, uint8_t* changed,
+                          std::size_t lanes) const {
+        const OscillatorDetectorParams params = m_params;
+        const uint32_t clock = m_clock;
+        const int64_t previousBase = m_timeBase;
+        const std::size_t count = Width == 1 ? lanes : Width;
+        for (std::size_t lane = 0; lane < count; ++lane) {
+            OscillatorDetectorState state = block.load(lane, clock);
+            OscillatorTimingState timing = timingBlock.load(lane, previousBase);
+            flags[lane] = Detector::stepTimed(params, state, timing, positions[lane], directions[lane], timestamps[lane]);
+            const bool stored = block.template store<Track>(lane, state, clock + 1) | timingBlock.template store<Track>(lane, timing, timeBase);
+            if constexpr (Track) {
+                changed[lane] = static_cast<uint8_t>(changed[lane] | stored);
+            }
+        }
+    }
+
+    // Width is a compile-time trip count for full blocks so the lane loop can be
+    // unrolled/vectorized; the partial last block runs with Width == 1 and uses
+    // the table-driven classification, which needs no if-conversion. The lanes
+    // load at the current clock and store at the next one, see Block.
+    template <std::size_t Width, bool Track>
+    void updateLanes(Block& block, const int64_t* positions, const int8_t* directions,
+                     uint8_t* flags, uint8_t* changed, std::size_t lanes) const {
+        const OscillatorDetectorParams params = m_params;
+        const uint32_t clock = m_clock;
+        const std::size_t count = Width == 1 ? lanes : Width;
+        for (std::size_t lane = 0; lane < count; ++lane) {
+            OscillatorDetectorState state = block.load(lane, clock);
+            flags[lane] = Width == 1 ? Detector::stepTable(params, state, positions[lane], directions[lane])
+                                     : Detector::step(params, state, positions[lane], directions[lane]);
+            const bool stored = block.template store<Track>(lane, state, clock + 1);
+            if constexpr (Track) {
+                changed[lane] |= stored;
+            }
+        }
+    }
+
+    std::size_t m_channels;
+    std::vector<Block> m_blocks;
+    std::vector<TimingBlock> m_timing; // empty until the first timestamped update
+    std::vector<DerivativeBlock> m_derivatives; // empty until the first update in a derived mode
+    std::vector<ErrorBlock> m_errors; // empty until the first updateError()
+    std::vector<uint64_t> m_dirty;    // one bit per channel changed since the last snapshot/checkpoint
+    bool m_tracking = false;          // set by the first snapshot/checkpoint; until then m_dirty is not kept
+    uint32_t m_clock = 0;             // dense updates so far, the time base of the Block stamps
+    int64_t m_timeBase = 0;           // first sample time of the latest timestamped dense update
+    OscillatorDetectorParams m_params;
+    mutable std::vector<uint16_t> m_scores;
+};
+
+
+/**
+ * @brief Detector bank with the original full-reset behavior.
+ */
+using OscillatorDetectorBank = BasicOscillatorDetectorBank<>;
@@ -0,0 +1,284 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2025, Szymon Bandel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "OscillatorDetector.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+
+/**
+ * @brief Always-on in-memory recorder of the last frames of detector inputs.
+ *
+ * Keeps the raw (position, direction) inputs of every channel for the last
+ * `frames` ticks in a ring, one row per tick. Each row is written with
+ * streaming (non-temporal) stores, so recording does not evict the detector
+ * state from the caches, and the copy has no data-dependent branches. Use one
+ * recorder per shard, next to its bank; recorders share nothing.
+ *
+ * The recorder freezes on freeze() (an external trigger), or when the tick
+ * passed to record() has a detection. A frozen recorder ignores further
+ * frames until resume(), so the window that led to the incident is kept, and
+ * dump() writes it as a binary trace.
+ *
+ * A recorder is not synchronized. Call dump() and the getters on the
+ * recording thread, or on another thread once recording has stopped and the
+ * recorder has been handed over through the usual synchronization (a mutex,
+ * a joined thread, a queue).
+ *
+ * Trace format, native byte order:
+ *  - header: char[8] "OSCFLT1", uint32 channel count, uint32 frame count,
+ *    uint64 index of the oldest frame (frames recorded before it),
+ *  - per channel: uint32 channel index, int64 positions[frames] and
+ *    int8 directions[frames], oldest first.
+ */
+class OscillatorFlightRecorder {
+public:
+    /**
+     * @param channels Channels per frame.
+     * @param frames Frames kept; rounded up to a power of two.
+     */
+    OscillatorFlightRecorder(std::size_t channels, std::size_t frames)
+        : m_channels(channels)
+        , m_capacity(roundUp(frames))
+        , m_positionStride((channels + 7) / 8)
+        , m_directionStride((channels + 63) / 64)
+        , m_positions(m_capacity * m_positionStride)
+        , m_directions(m_capacity * m_directionStride) {}
+
+    /**
+     * @brief Record one frame, unless frozen.
+     * @param positions, directions One entry per channel, as passed to the bank.
+     */
+    void record(const int64_t* positions, const int8_t* directions) {
+        if (m_frozen) {
+            return;
+        }
+        const std::size_t slot = static_cast<std::size_t>(m_recorded) & (m_capacity - 1);
+        stream(m_positions[slot * m_positionStride].values, positions, m_channels);
+        stream(m_directions[slot * m_directionStride].values, directions, m_channels);
+        ++m_recorded;
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+        _mm_sfence(); // streaming stores are weakly ordered; complete them before any later hand-over
+#endif
+    }
+
+    /**
+     * @brief Record one frame and freeze if any channel reports a detection.
+     *
+     * The per-channel events are only read on the tick that freezes, to
+     * collect the affected channels, so recording costs no pass over them.
+     * @param events The OscillatorEvent flags of the same tick, e.g. from the bank update.
+     * @param any The flags of all channels ORed together, as returned by the bank update.
+     * @return true if the recorder is frozen.
+     */
+    bool record(const int64_t* positions, const int8_t* directions, const uint8_t* events, uint8_t any) {
+        if (m_frozen) {
+            return true;
+        }
+        record(positions, directions);
+        if ((any & OscillatorEvent::Detected) != 0) {
+            m_affected.clear();
+            for (std::size_t channel = 0; channel < m_channels; ++channel) {
+                if ((events[channel] & OscillatorEvent::Detected) != 0) {
+                    m_affected.push_back(static_cast<uint32_t>(channel));
+                }
+            }
+            m_frozen = true;
+        }
+        return m_frozen;
+    }
+
+    /**
+     * @brief External trigger: keep the current window.
+     * @param channels, count Channels dump() writes by default; count 0 keeps the previous selection.
+     */
+    void freeze(const uint32_t* channels = nullptr, std::size_t count = 0) {
+        if (count != 0) {
+            m_affected.assign(channels, channels + count);
+        }
+        m_frozen = true;
+    }
+
+    /**
+     * @brief Continue recording after a freeze.
+     */
+    void resume() {
+        m_frozen = false;
+    }
+
+    /**
+     * @brief Check whether the recorder is frozen.
+     */
+    bool isFrozen() const {
+        return m_frozen;
+    }
+
+    /**
+     * @brief Get the channels selected by the last trigger, see freeze() and record().
+     */
+    const std::vector<uint32_t>& getAffected() const {
+        return m_affected;
+    }
+
+    /**
+     * @brief Get the number of frames held, at most the capacity.
+     */
+    std::size_t size() const {
+        return m_recorded < m_capacity ? static_cast<std::size_t>(m_recorded) : m_capacity;
+    }
+
+    /**
+     * @brief Get the number of frames kept.
+     */
+    std::size_t capacity() const {
+        return m_capacity;
+    }
+
+    /**
+     * @brief Get a recorded position.
+     * @param age 0 for the newest frame, up to size() - 1.
+     */
+    int64_t getPosition(std::size_t age, std::size_t channel) const {
+        return m_positions[row(age) * m_positionStride + channel / 8].values[channel % 8];
+    }
+
+    /**
+     * @brief Get a recorded direction.
+     * @param age 0 for the newest frame, up to size() - 1.
+     */
+    int getDirection(std::size_t age, std::size_t channel) const {
+        return m_directions[row(age) * m_directionStride + channel / 64].values[channel % 64];
+    }
+
+    /**
+     * @brief Write the window of the affected channels as a binary trace.
+     */
+    void dump(std::ostream& out) const {
+        dump(m_affected.data(), m_affected.size(), out);
+    }
+
+    /**
+     * @brief Write the window of the given channels as a binary trace, see the class description.
+     */
+    void dump(const uint32_t* channels, std::size_t count, std::ostream& out) const {
+        const std::size_t frames = size();
+        const char magic[8] = "OSCFLT1";
+        const uint32_t channelCount = static_cast<uint32_t>(count);
+        const uint32_t frameCount = static_cast<uint32_t>(frames);
+        const uint64_t first = m_recorded - frames;
+        write(out, magic, sizeof(magic));
+        write(out, &channelCount, sizeof(channelCount));
+        write(out, &frameCount, sizeof(frameCount));
+        write(out, &first, sizeof(first));
+        std::vector<int64_t> positions(frames);
+        std::vector<int8_t> directions(frames);
+        for (std::size_t i = 0; i < count; ++i) {
+            for (std::size_t frame = 0; frame < frames; ++frame) {
+                positions[frame] = getPosition(frames - 1 - frame, channels[i]);
+                directions[frame] = static_cast<int8_t>(getDirection(frames - 1 - frame, channels[i]));
+            }
+            write(out, &channels[i], sizeof(uint32_t));
+            write(out, positions.data(), frames * sizeof(int64_t));
+            write(out, directions.data(), frames * sizeof(int8_t));
+        }
+    }
+
+private:
+    // Cache-line sized pieces of a row; the vectors of them are 64-byte aligned.
+    struct alignas(64) PositionLine {
+        int64_t values[8];
+    };
+
+    struct alignas(64) DirectionLine {
+        int8_t values[64];
+    };
+
+    static std::size_t roundUp(std::size_t frames) {
+        std::size_t capacity = 1;
+        while (capacity < frames) {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+    std::size_t row(std::size_t age) const {
+        return static_cast<std::size_t>(m_recorded - 1 - age) & (m_capacity - 1);
+    }
+
+    static void write(std::ostream& out, const void* data, std::size_t bytes) {
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+    }
+
+    // Non-temporal copy into a 64-byte aligned row; the tail uses regular stores.
+    template <typename T>
+    static void stream(T* destination, const T* source, std::size_t count) {
+        const std::size_t bytes = count * sizeof(T);
+        char* to = reinterpret_cast<char*>(destination);
+        const char* from = reinterpret_cast<const char*>(source);
+        std::size_t offset = 0;
+#if defined(__AVX2__)
+        for (; offset + 32 <= bytes; offset += 32) {
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(to + offset),
+                                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from + offset)));
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        for (; offset + 16 <= bytes; offset += 16) {
+            _mm_stream_si128(reinterpret_cast<__m128i*>(to + offset),
+                             _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + offset)));
+        }
+#endif
+        std::memcpy(to + offset, from + offset, bytes - offset);
+    }
+
+    std::size_t m_channels;
+    std::size_t m_capacity;
+    std::size_t m_positionStride;       // lines per row
+    std::size_t m_directionStride;
+    std::vector<PositionLine> m_positions;
+    std::vector<DirectionLine> m_directions;
+    uint64_t m_recorded = 0;            // frames recorded so far
+    bool m_frozen = false;
+    std::vector<uint32_t> m_affected;
+};
@@ -0,0 +1,149 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2025, Szymon Bandel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "OscillatorDetector.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+/**
+ * @brief What an OscillatorHistory entry records.
+ */
+enum class OscillatorHistoryKind : uint8_t {
+    Maximum,    // a counted maximum
+    Minimum,    // a counted minimum
+    Reset,      // the reset policy was applied
+};
+
+/**
+ * @brief One entry of an OscillatorHistory.
+ */
+struct OscillatorHistoryEntry {
+    int64_t sample{ 0 };        // sample index (or timestamp) passed to record()
+    int64_t position{ 0 };      // position of the update that produced the entry
+    OscillatorHistoryKind kind{ OscillatorHistoryKind::Maximum };
+};
+
+/**
+ * @brief Bounded history of the last counted extrema and resets of one detector.
+ *
+ * Keeps the newest `Capacity` entries in a fixed ring, so after an alarm the
+ * extrema that led to it can be inspected without a raw recording of the
+ * channel. Feed it the flags returned by update():
+ * @code
+ * history.record(sampleIndex, position, detector.update(position, direction));
+ * @endcode
+ * Updates without an extremum or reset cost one test. Works the same with the
+ * per-channel events of a bank.
+ * @tparam Capacity Entries kept; a power of two.
+ */
+template <std::size_t Capacity = 16>
+class OscillatorHistory {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    /**
+     * @brief Record the outcome of one detector update.
+     * @param sample Index or timestamp of the update.
+     * @param position Position passed to the update.
+     * @param events OscillatorEvent flags returned by the update.
+     */
+    void record(int64_t sample, int64_t position, uint8_t events) {
+        if ((events & (OscillatorEvent::Extremum | OscillatorEvent::Reset)) == 0) {
+            return;
+        }
+        if (events & OscillatorEvent::Extremum) {
+            push({ sample, position, (events & OscillatorEvent::Maximum) ? OscillatorHistoryKind::Maximum
+                                                                          : OscillatorHistoryKind::Minimum });
+        }
+        if (events & OscillatorEvent::Reset) {
+            push({ sample, position, OscillatorHistoryKind::Reset });
+        }
+    }
+
+    /**
+     * @brief Get the number of entries held, at most Capacity.
+     */
+    std::size_t size() const {
+        return m_total < Capacity ? static_cast<std::size_t>(m_total) : Capacity;
+    }
+
+    /**
+     * @brief Get the number of entries ever recorded, including overwritten ones.
+     */
+    uint64_t getTotal() const {
+        return m_total;
+    }
+
+    /**
+     * @brief Get an entry; 0 is the oldest held, size() - 1 the newest.
+     */
+    const OscillatorHistoryEntry& operator[](std::size_t index) const {
+        return m_entries[(m_total - size() + index) & Mask];
+    }
+
+    /**
+     * @brief Copy the held entries, oldest first.
+     * @param entries Receives size() entries.
+     * @return The number of entries written.
+     */
+    std::size_t copy(OscillatorHistoryEntry* entries) const {
+        const std::size_t count = size();
+        for (std::size_t i = 0; i < count; ++i) {
+            entries[i] = (*this)[i];
+        }
+        return count;
+    }
+
+    /**
+     * @brief Forget every entry.
+     */
+    void reset() {
+        m_total = 0;
+    }
+
+private:
+    static constexpr std::size_t Mask = Capacity - 1;
+
+    void push(const OscillatorHistoryEntry& entry) {
+        m_entries[m_total & Mask] = entry;
+        ++m_total;
+    }
+
+    std::array<OscillatorHistoryEntry, Capacity> m_entries{};
+    uint64_t m_total = 0;
+};
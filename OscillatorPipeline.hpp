@@ -0,0 +1,472 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2025, Szymon Bandel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "OscillatorDetector.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief A batch of consecutive samples of one stream.
+ *
+ * Batches are the unit passed between pipeline stages, so the per-hop
+ * synchronization cost is paid once per batch instead of once per sample.
+ */
+struct SampleBatch {
+    uint32_t stream{ 0 };
+    uint64_t firstSample{ 0 };          // sample index of positions[0] within the stream
+    std::vector<int64_t> positions;
+    std::vector<int8_t> directions;     // same length as positions
+};
+
+/**
+ * @brief A sample for which the detector reported oscillation.
+ */
+struct DetectionEvent {
+    uint32_t stream{ 0 };
+    uint64_t sampleIndex{ 0 };
+    int64_t position{ 0 };
+};
+
+
+/**
+ * @brief Small fixed-size thread pool that resumes pipeline coroutines.
+ *
+ * Suspended coroutines cost only their frame, so thousands of streams can be
+ * multiplexed onto a handful of worker threads. All coroutines must have
+ * finished (see PipelineTask::join()) before the executor is destroyed.
+ */
+class PipelineExecutor {
+public:
+    explicit PipelineExecutor(unsigned threads = std::thread::hardware_concurrency()) {
+        if (threads == 0) {
+            threads = 1;
+        }
+        m_workers.reserve(threads);
+        for (unsigned i = 0; i < threads; ++i) {
+            m_workers.emplace_back([this] { run(); });
+        }
+    }
+
+    ~PipelineExecutor() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wakeup.notify_all();
+        for (auto& worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    PipelineExecutor(const PipelineExecutor&) = delete;
+    PipelineExecutor& operator=(const PipelineExecutor&) = delete;
+
+    /**
+     * @brief Queue a suspended coroutine to be resumed on one of the workers.
+     */
+    void post(std::coroutine_handle<> handle) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_ready.push_back(handle);
+        }
+        m_wakeup.notify_one();
+    }
+
+    /**
+     * @brief Awaitable that reschedules the awaiting coroutine on the executor.
+     *
+     * Useful for sources that wake up on a foreign thread (e.g. an I/O
+     * completion) and want to continue their work on the pool.
+     */
+    auto schedule() {
+        struct Awaiter {
+            PipelineExecutor& executor;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { executor.post(handle); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{ *this };
+    }
+
+    /**
+     * @brief Get the number of worker threads.
+     */
+    std::size_t getThreadCount() const {
+        return m_workers.size();
+    }
+
+private:
+    void run() {
+        for (;;) {
+            std::coroutine_handle<> handle;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wakeup.wait(lock, [this] { return m_stopping || !m_ready.empty(); });
+                if (m_ready.empty()) {
+                    return; // stopping and nothing left to run
+                }
+                handle = m_ready.front();
+                m_ready.pop_front();
+            }
+            handle.resume();
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::deque<std::coroutine_handle<>> m_ready;
+    bool m_stopping{ false };
+    std::vector<std::thread> m_workers;
+};
+
+
+/**
+ * @brief Coroutine type for pipeline sources, stages and sinks.
+ *
+ * The coroutine is created suspended and starts running on the executor once
+ * start() is called. join() blocks until it has finished and rethrows any
+ * exception that escaped the coroutine body.
+ */
+class PipelineTask {
+    struct Completion {
+        std::atomic<bool> done{ false };
+        std::exception_ptr error;
+    };
+
+public:
+    struct promise_type {
+        std::shared_ptr<Completion> completion{ std::make_shared<Completion>() };
+
+        PipelineTask get_return_object() {
+            return PipelineTask{ std::coroutine_handle<promise_type>::from_promise(*this) };
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        auto final_suspend() noexcept {
+            struct Awaiter {
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                    // The joiner may destroy the frame as soon as done is set, so
+                    // only touch the shared completion state from here on.
+                    std::shared_ptr<Completion> completion = handle.promise().completion;
+                    completion->done.store(true, std::memory_order_release);
+                    completion->done.notify_all();
+                }
+                void await_resume() const noexcept {}
+            };
+            return Awaiter{};
+        }
+
+        void return_void() {}
+
+        void unhandled_exception() {
+            completion->error = std::current_exception();
+        }
+    };
+
+    PipelineTask() = default;
+
+    PipelineTask(PipelineTask&& other) noexcept
+        : m_handle(std::exchange(other.m_handle, nullptr))
+        , m_started(std::exchange(other.m_started, false)) {}
+
+    PipelineTask& operator=(PipelineTask&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            m_handle = std::exchange(other.m_handle, nullptr);
+            m_started = std::exchange(other.m_started, false);
+        }
+        return *this;
+    }
+
+    ~PipelineTask() {
+        destroy();
+    }
+
+    /**
+     * @brief Schedule the coroutine for its first run on the given executor.
+     */
+    void start(PipelineExecutor& executor) {
+        m_started = true;
+        executor.post(m_handle);
+    }
+
+    /**
+     * @brief Block the calling thread until the coroutine has finished.
+     *
+     * The task must have been started, otherwise nothing would ever finish it.
+     * Must not be called from inside a pipeline coroutine.
+     */
+    void join() {
+        assert(m_started && "join() on a task that was never started");
+        Completion& completion = *m_handle.promise().completion;
+        completion.done.wait(false, std::memory_order_acquire);
+        if (completion.error) {
+            std::rethrow_exception(completion.error);
+        }
+    }
+
+    /**
+     * @brief Check whether the coroutine has run to completion.
+     */
+    bool isDone() const {
+        return m_handle && m_handle.promise().completion->done.load(std::memory_order_acquire);
+    }
+
+private:
+    explicit PipelineTask(std::coroutine_handle<promise_type> handle)
+        : m_handle(handle) {}
+
+    void destroy() {
+        if (m_handle) {
+            // A never-started frame is suspended at its initial point and can be
+            // destroyed right away; a started one has to reach final_suspend first.
+            if (m_started) {
+                m_handle.promise().completion->done.wait(false, std::memory_order_acquire);
+            }
+            m_handle.destroy();
+            m_handle = nullptr;
+        }
+    }
+
+    std::coroutine_handle<promise_type> m_handle{ nullptr };
+    bool m_started{ false };
+};
+
+
+/**
+ * @brief Bounded multi-producer/multi-consumer channel between pipeline stages.
+ *
+ * push() suspends the producer while the channel holds `capacity` items and
+ * pop() suspends the consumer while it is empty, which gives natural
+ * back-pressure between stages. Suspended coroutines are resumed through the
+ * executor, never inline on the thread that unblocked them.
+ *
+ * A channel fed by several producers that end on their own (e.g. detector
+ * stages fanning into one event channel) is constructed with their count;
+ * each calls finish() when done and the last one closes the channel.
+ */
+template <typename T>
+class AsyncChannel {
+public:
+    AsyncChannel(PipelineExecutor& executor, std::size_t capacity, std::size_t producers = 1)
+        : m_executor(executor)
+        , m_capacity(capacity == 0 ? 1 : capacity)
+        , m_producers(producers == 0 ? 1 : producers) {}
+
+    AsyncChannel(const AsyncChannel&) = delete;
+    AsyncChannel& operator=(const AsyncChannel&) = delete;
+
+    /**
+     * @brief Awaitable push; resumes with false if the channel has been closed.
+     */
+    auto push(T value) {
+        return PushAwaiter{ *this, std::move(value) };
+    }
+
+    /**
+     * @brief Awaitable pop; resumes with std::nullopt once closed and drained.
+     */
+    auto pop() {
+        return PopAwaiter{ *this };
+    }
+
+    /**
+     * @brief Close the channel and wake every suspended producer and consumer.
+     *
+     * Items already queued can still be popped.
+     */
+    void close() {
+        std::vector<std::coroutine_handle<>> wake;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+            for (PushAwaiter* pusher : m_pushers) {
+                pusher->accepted = false;
+                wake.push_back(pusher->handle);
+            }
+            for (PopAwaiter* popper : m_poppers) {
+                wake.push_back(popper->handle);
+            }
+            m_pushers.clear();
+            m_poppers.clear();
+        }
+        for (auto handle : wake) {
+            m_executor.post(handle);
+        }
+    }
+
+    /**
+     * @brief Mark one producer as finished; the last one closes the channel.
+     */
+    void finish() {
+        if (m_producers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            close();
+        }
+    }
+
+private:
+    struct PushAwaiter {
+        AsyncChannel& channel;
+        T value;
+        bool accepted{ true };
+        std::coroutine_handle<> handle{};
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> awaiting) {
+            handle = awaiting;
+            std::coroutine_handle<> wake{};
+            {
+                std::lock_guard<std::mutex> lock(channel.m_mutex);
+                if (channel.m_closed) {
+                    accepted = false;
+                    return false;
+                }
+                if (!channel.m_poppers.empty()) {
+                    PopAwaiter* popper = channel.m_poppers.front();
+                    channel.m_poppers.pop_front();
+                    popper->result.emplace(std::move(value));
+                    wake = popper->handle;
+                }
+                else if (channel.m_items.size() < channel.m_capacity) {
+                    channel.m_items.push_back(std::move(value));
+                }
+                else {
+                    channel.m_pushers.push_back(this);
+                    return true;
+                }
+            }
+            if (wake) {
+                channel.m_executor.post(wake);
+            }
+            return false;
+        }
+
+        bool await_resume() const noexcept { return accepted; }
+    };
+
+    struct PopAwaiter {
+        AsyncChannel& channel;
+        std::optional<T> result{};
+        std::coroutine_handle<> handle{};
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> awaiting) {
+            handle = awaiting;
+            std::coroutine_handle<> wake{};
+            {
+                std::lock_guard<std::mutex> lock(channel.m_mutex);
+                if (!channel.m_items.empty()) {
+                    result.emplace(std::move(channel.m_items.front()));
+                    channel.m_items.pop_front();
+                    if (!channel.m_pushers.empty()) {
+                        PushAwaiter* pusher = channel.m_pushers.front();
+                        channel.m_pushers.pop_front();
+                        channel.m_items.push_back(std::move(pusher->value));
+                        wake = pusher->handle;
+                    }
+                }
+                else if (!channel.m_closed) {
+                    channel.m_poppers.push_back(this);
+                    return true;
+                }
+            }
+            if (wake) {
+                channel.m_executor.post(wake);
+            }
+            return false;
+        }
+
+        std::optional<T> await_resume() { return std::move(result); }
+    };
+
+    PipelineExecutor& m_executor;
+    const std::size_t m_capacity;
+    std::atomic<std::size_t> m_producers;
+    std::mutex m_mutex;
+    std::deque<T> m_items;
+    std::deque<PushAwaiter*> m_pushers;
+    std::deque<PopAwaiter*> m_poppers;
+    bool m_closed{ false };
+};
+
+
+using SampleChannel = AsyncChannel<SampleBatch>;
+using EventChannel = AsyncChannel<std::vector<DetectionEvent>>;
+
+
+/**
+ * @brief Detector stage: runs every batch popped from `input` through `detector`.
+ *
+ * Detections of one input batch are forwarded as a single event batch, empty
+ * batches are not forwarded. The stage finishes when `input` is closed and
+ * drained or when `output` is closed, and then calls output.finish(), so a
+ * sink popping `output` ends once every stage feeding it has ended. The
+ * channels and the detector are taken by reference and must outlive the
+ * returned task.
+ */
+template <typename Detector>
+PipelineTask detectorStage(SampleChannel& input, EventChannel& output, Detector& detector) {
+    while (std::optional<SampleBatch> batch = co_await input.pop()) {
+        std::vector<DetectionEvent> events;
+        const std::size_t count = batch->positions.size();
+        for (std::size_t i = 0; i < count; ++i) {
+            if (detector.detect(batch->positions[i], batch->directions[i])) {
+                events.push_back({ batch->stream, batch->firstSample + i, batch->positions[i] });
+            }
+        }
+        if (!events.empty() && !co_await output.push(std::move(events))) {
+            break;
+        }
+    }
+    output.finish();
+}
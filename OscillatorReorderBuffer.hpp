@@ -0,0 +1,217 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2025, Szymon Bandel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+
+/**
+ * @brief A timestamped sample as it arrives from the transport.
+ */
+struct OscillatorSample {
+    int64_t timestamp{ 0 };     ///< Sample time in nanoseconds.
+    int64_t position{ 0 };
+    int8_t direction{ 0 };
+};
+
+/**
+ * @brief Per-channel stage that restores the order of samples arriving out of order.
+ *
+ * Samples are kept sorted by timestamp in a fixed ring of `Capacity` entries;
+ * transports deliver nearly sorted data, so the insertion sort usually moves
+ * nothing. A sample is released once the watermark passes it. The watermark is
+ * the latest timestamp seen minus the allowed lateness, or a later value given
+ * to advance() (e.g. from a gateway heartbeat). Samples older than the
+ * watermark arrive too late to be ordered and are dropped. When the ring is
+ * full, its oldest sample is released early. Nothing is allocated.
+ *
+ * Released samples are passed, in timestamp order, to a sink such as
+ * `[&](const OscillatorSample& s) { detector.update(s.position, s.direction, s.timestamp); }`.
+ * @tparam Capacity Samples held at most; a power of two.
+ */
+template <std::size_t Capacity = 32>
+class OscillatorReorderBuffer {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    /**
+     * @param lateness How far behind the latest sample a sample may arrive, in nanoseconds.
+     */
+    explicit OscillatorReorderBuffer(int64_t lateness = 0)
+        : m_lateness(lateness) {}
+
+    /**
+     * @brief Insert a sample and release every sample the watermark has passed.
+     * @param sample The arriving sample.
+     * @param sink Called with each released sample, in timestamp order.
+     * @return False if the sample arrived too late and was dropped.
+     */
+    template <typename Sink>
+    bool push(const OscillatorSample& sample, Sink&& sink) {
+        if (sample.timestamp < m_watermark) {
+            ++m_dropped;
+            return false;
+        }
+        if (m_count == Capacity) {
+            if (sample.timestamp < m_ring[m_head].timestamp) {
+                m_watermark = sample.timestamp; // older than everything held
+                sink(sample);
+                return true;
+            }
+            m_watermark = m_ring[m_head].timestamp;
+            release(sink);
+        }
+
+        // Shift the later samples up by one; on sorted input the loop does not run.
+        std::size_t index = m_head + m_count;
+        while (index != m_head && m_ring[(index - 1) & Mask].timestamp > sample.timestamp) {
+            m_ring[index & Mask] = m_ring[(index - 1) & Mask];
+            --index;
+        }
+        m_ring[index & Mask] = sample;
+        ++m_count;
+
+        if (sample.timestamp > m_latest) {
+            m_latest = sample.timestamp;
+            advance(behind(m_latest, m_lateness), sink);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Move the watermark forward and release the samples it has passed.
+     * @param watermark Samples at or before this time are released; later arrivals before it are dropped.
+     * @param sink Called with each released sample, in timestamp order.
+     * @return The number of samples released.
+     */
+    template <typename Sink>
+    std::size_t advance(int64_t watermark, Sink&& sink) {
+        if (watermark > m_watermark) {
+            m_watermark = watermark;
+        }
+        std::size_t released = 0;
+        while (m_count != 0 && m_ring[m_head].timestamp <= m_watermark) {
+            release(sink);
+            ++released;
+        }
+        return released;
+    }
+
+    /**
+     * @brief Release every held sample, e.g. at the end of a stream.
+     */
+    template <typename Sink>
+    std::size_t flush(Sink&& sink) {
+        return advance(m_latest, sink);
+    }
+
+    /**
+     * @brief Forget every held sample and the watermark; the dropped count is kept.
+     */
+    void reset() {
+        m_head = 0;
+        m_count = 0;
+        m_latest = std::numeric_limits<int64_t>::min();
+        m_watermark = std::numeric_limits<int64_t>::min();
+    }
+
+    /**
+     * @brief Set how far behind the latest sample a sample may arrive, in nanoseconds.
+     *
+     * Larger values reorder more but delay every sample by up to this much.
+     */
+    void setLateness(int64_t nanoseconds) {
+        m_lateness = nanoseconds;
+    }
+
+    /**
+     * @brief Get the allowed lateness in nanoseconds.
+     */
+    int64_t getLateness() const {
+        return m_lateness;
+    }
+
+    /**
+     * @brief Get the current watermark; earlier samples are dropped.
+     */
+    int64_t getWatermark() const {
+        return m_watermark;
+    }
+
+    /**
+     * @brief Get the number of samples held.
+     */
+    std::size_t size() const {
+        return m_count;
+    }
+
+    /**
+     * @brief Get the number of samples dropped for arriving too late.
+     */
+    uint64_t getDropped() const {
+        return m_dropped;
+    }
+
+private:
+    static constexpr std::size_t Mask = Capacity - 1;
+
+    // time - lateness, saturated so that timestamps near the int64 limits do not overflow.
+    static int64_t behind(int64_t time, int64_t lateness) {
+        constexpr int64_t lowest = std::numeric_limits<int64_t>::min();
+        constexpr int64_t highest = std::numeric_limits<int64_t>::max();
+        if (lateness >= 0) {
+            return time < lowest + lateness ? lowest : time - lateness;
+        }
+        return time > highest + lateness ? highest : time - lateness;
+    }
+
+    template <typename Sink>
+    void release(Sink& sink) {
+        const OscillatorSample sample = m_ring[m_head];
+        m_head = (m_head + 1) & Mask;
+        --m_count;
+        sink(sample);
+    }
+
+    std::array<OscillatorSample, Capacity> m_ring{};
+    std::size_t m_head = 0;
+    std::size_t m_count = 0;
+    int64_t m_lateness;
+    int64_t m_latest = std::numeric_limits<int64_t>::min();
+    int64_t m_watermark = std::numeric_limits<int64_t>::min();
+    uint64_t m_dropped = 0;
+};
@@ -0,0 +1,180 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2025, Szymon Bandel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "OscillatorDetector.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/**
+ * @brief Seekable recording of one detector run, for inspecting past detector states.
+ *
+ * In the first pass every input goes through record(). It updates a live
+ * detector, appends the input to the trace and keeps a copy of the detector
+ * every `interval` samples. seek(n) then restores the detector as it was after
+ * the first n samples. It starts from the last checkpoint at or before n, or
+ * continues from the previous seek if that is closer, so a seek costs at most
+ * interval - 1 detector steps. The returned detector exposes getState(),
+ * getTimingState() and getDerivativeState() at that point.
+ *
+ * The trace takes 9 bytes per sample (17 when timestamped) plus one detector
+ * copy per interval. The first record() fixes the form of the trace: later
+ * calls must use the same overload, which debug builds assert.
+ * @tparam ResetPolicy See OscillatorReset.
+ */
+template <typename ResetPolicy = OscillatorReset::Full>
+class BasicOscillatorReplay {
+public:
+    using Detector = BasicOscillatorDetector<ResetPolicy>;
+
+    /**
+     * @param detector Configured detector the trace starts from, usually a fresh one.
+     * @param interval Samples between checkpoints; larger saves memory, smaller makes seeks cheaper.
+     */
+    explicit BasicOscillatorReplay(const Detector& detector = Detector{}, std::size_t interval = 1024)
+        : m_interval(std::max<std::size_t>(interval, 1))
+        , m_live(detector)
+        , m_cursor(detector) {
+        m_checkpoints.push_back(detector);
+    }
+
+    /**
+     * @brief Update the live detector and record the input.
+     * @return The OscillatorEvent flags of the live update.
+     */
+    uint8_t record(int64_t position, int direction) {
+        assert(m_timestamps.empty() && "timestamped trace recorded without a timestamp");
+        const uint8_t events = m_live.update(position, direction);
+        append(position, direction);
+        return events;
+    }
+
+    /**
+     * @brief Same as record(position, direction) for timestamped updates.
+     */
+    uint8_t record(int64_t position, int direction, int64_t timestamp) {
+        assert(m_timestamps.size() == m_positions.size() && "count-based trace recorded with a timestamp");
+        const uint8_t events = m_live.update(position, direction, timestamp);
+        m_timestamps.push_back(timestamp);
+        append(position, direction);
+        return events;
+    }
+
+    /**
+     * @brief Restore the detector as it was after the first `sample` recorded samples.
+     * @param sample 0 for the initial state, at most size().
+     * @return The detector at that point; valid until the next seek().
+     */
+    const Detector& seek(std::size_t sample) {
+        sample = std::min(sample, size());
+        const std::size_t checkpoint = sample / m_interval;
+        if (sample < m_cursorSample || m_cursorSample < checkpoint * m_interval) {
+            m_cursor = m_checkpoints[checkpoint];
+            m_cursorSample = checkpoint * m_interval;
+        }
+        for (; m_cursorSample < sample; ++m_cursorSample) {
+            if (m_cursorSample >= m_timestamps.size()) {
+                m_cursor.update(m_positions[m_cursorSample], m_directions[m_cursorSample]);
+            }
+            else {
+                m_cursor.update(m_positions[m_cursorSample], m_directions[m_cursorSample], m_timestamps[m_cursorSample]);
+            }
+        }
+        return m_cursor;
+    }
+
+    /**
+     * @brief Get the number of recorded samples.
+     */
+    std::size_t size() const {
+        return m_positions.size();
+    }
+
+    /**
+     * @brief Get the samples between checkpoints.
+     */
+    std::size_t getInterval() const {
+        return m_interval;
+    }
+
+    /**
+     * @brief Get the recorded position of one sample.
+     */
+    int64_t getPosition(std::size_t sample) const {
+        return m_positions[sample];
+    }
+
+    /**
+     * @brief Get the recorded direction of one sample.
+     */
+    int getDirection(std::size_t sample) const {
+        return m_directions[sample];
+    }
+
+    /**
+     * @brief Get the detector that record() updates, in its state after the last sample.
+     */
+    const Detector& getLive() const {
+        return m_live;
+    }
+
+private:
+    void append(int64_t position, int direction) {
+        m_positions.push_back(position);
+        m_directions.push_back(static_cast<int8_t>(direction));
+        if (m_positions.size() % m_interval == 0) {
+            m_checkpoints.push_back(m_live);
+        }
+    }
+
+    std::size_t m_interval;
+    Detector m_live;
+    Detector m_cursor;                  // state after m_cursorSample samples
+    std::size_t m_cursorSample = 0;
+    std::vector<Detector> m_checkpoints; // [k]: state after k * m_interval samples
+    std::vector<int64_t> m_positions;
+    std::vector<int8_t> m_directions;
+    std::vector<int64_t> m_timestamps;  // one per sample, or empty for count-based traces
+};
+
+
+/**
+ * @brief Replay of a detector with the original full-reset behavior.
+ */
+using OscillatorReplay = BasicOscillatorReplay<>;
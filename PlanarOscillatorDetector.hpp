@@ -0,0 +1,468 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2025, Szymon Bandel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "OscillatorDetector.hpp"
+#include "OscillatorDetectorBank.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/**
+ * @brief Parameters of the planar front end, shared by all channels of a bank.
+ */
+struct PlanarOscillatorParams {
+    uint8_t baselineShift = 6;      ///< Centre EMA weight 2^-shift (6: time constant of 64 samples).
+    uint8_t covarianceShift = 6;    ///< Covariance EMA weight 2^-shift, principal axis only.
+    int64_t axisTolerance = 2048;   ///< Turn of the axis estimate that re-latches the projection, a Q15 sine (2048: 2-4 degrees).
+};
+
+/**
+ * @brief Per-channel state of the planar front end.
+ */
+struct PlanarOscillatorState {
+    int64_t centerX = 0;            ///< Centre << baselineShift.
+    int64_t centerY = 0;
+    int64_t covarianceXX = 0;       ///< EMA of the products of the deviations from the centre.
+    int64_t covarianceYY = 0;
+    int64_t covarianceXY = 0;
+    int64_t axisX = 32767;          ///< Principal axis estimate, larger component 32767; starts at 20 degrees.
+    int64_t axisY = 11926;
+    int64_t latchX = 32767;         ///< Axis the positions are projected onto.
+    int64_t latchY = 11926;
+    int64_t offset = 0;             ///< Keeps the value continuous across re-latches.
+    int64_t lastValue = 0;
+    bool primed = false;            ///< The centre has been initialized with the first sample.
+};
+
+
+/**
+ * @brief Oscillation detector for motion in a plane along an arbitrary direction.
+ *
+ * An XY position is reduced to one value per sample, which drives a regular
+ * OscillatorDetector together with the direction of change of that value.
+ * The value is the position projected onto the principal axis of the motion,
+ * the dominant eigenvector of the running covariance of the deviations from a
+ * slowly tracked centre. One power-iteration step per sample keeps the
+ * estimate current, so a motion that turns is followed within a few covariance
+ * time constants.
+ *
+ * The projection axis is latched and only moves to the estimate once that has
+ * turned by more than axisTolerance. The detector counts an extremum only if it
+ * is at or beyond the tracked one, so a projection that wobbled by a unit from
+ * cycle to cycle would stall it; with the latched axis the reduced signal is
+ * exactly the coordinate along the motion, and the detector behaves as it would
+ * on a one-dimensional input. A re-latch shifts the value to keep it continuous.
+ *
+ * All arithmetic is integer; deviations from the centre must stay within
+ * +-2^30 and positions within +-2^46.
+ */
+class PlanarOscillatorDetector {
+public:
+    /**
+     * @brief Detect an oscillation of the position (x, y).
+     * @return true if the detector on the reduced signal reports oscillation.
+     */
+    bool detect(int64_t x, int64_t y) {
+        return (update(x, y) & OscillatorEvent::Detected) != 0;
+    }
+
+    /**
+     * @brief Same as detect(), but reports everything that happened during the update.
+     * @return A combination of OscillatorEvent flags.
+     */
+    uint8_t update(int64_t x, int64_t y) {
+        int direction = 0;
+        const int64_t value = project(m_params, m_state, x, y, direction);
+        return m_detector.update(value, direction);
+    }
+
+    /**
+     * @brief Reduce one XY sample to the tracked value; the kernel shared with the bank.
+     * @param direction Receives the direction of change of the value, 0 on the first sample.
+     * @return The value to pass to the detector.
+     */
+    static int64_t project(const PlanarOscillatorParams& params, PlanarOscillatorState& state,
+                           int64_t x, int64_t y, int& direction) {
+        const int shift = params.baselineShift;
+        state.centerX = state.primed ? state.centerX + x - (state.centerX >> shift) : x * (int64_t{ 1 } << shift);
+        state.centerY = state.primed ? state.centerY + y - (state.centerY >> shift) : y * (int64_t{ 1 } << shift);
+        const int64_t dx = x - (state.centerX >> shift);
+        const int64_t dy = y - (state.centerY >> shift);
+
+        // Covariance EMAs and one power-iteration step toward their dominant eigenvector.
+        const int cs = params.covarianceShift;
+        state.covarianceXX += (dx * dx - state.covarianceXX) >> cs;
+        state.covarianceYY += (dy * dy - state.covarianceYY) >> cs;
+        state.covarianceXY += (dx * dy - state.covarianceXY) >> cs;
+        const int scale = bitWidth(std::max(std::max(magnitude(state.covarianceXX), magnitude(state.covarianceYY)),
+                                            magnitude(state.covarianceXY))) - 30;
+        const int64_t a = normalize(state.covarianceXX, scale);
+        const int64_t b = normalize(state.covarianceYY, scale);
+        const int64_t c = normalize(state.covarianceXY, scale);
+        const int64_t nextX = a * state.axisX + c * state.axisY;
+        const int64_t nextY = c * state.axisX + b * state.axisY;
+
+        // Rescale so the larger component is 32767 again. The components are
+        // shifted to at most 31 bits and scaled by one float reciprocal; there is
+        // no integer division, and the selects below are masks, not branches.
+        const uint64_t largest = std::max(magnitude(nextX), magnitude(nextY));
+        const int width = std::max(bitWidth(largest) - 31, 0);
+        const float reciprocal = 32767.0f / static_cast<float>(static_cast<int64_t>((largest >> width) | 1));
+        const int64_t scaledX = static_cast<int64_t>(static_cast<float>(nextX >> width) * reciprocal);
+        const int64_t scaledY = static_cast<int64_t>(static_cast<float>(nextY >> width) * reciprocal);
+        const int64_t keep = -static_cast<int64_t>(largest == 0);   // no motion yet: keep the previous axis
+        state.axisX = (state.axisX & keep) | (scaledX & ~keep);
+        state.axisY = (state.axisY & keep) | (scaledY & ~keep);
+
+        // Re-latch once the estimate has turned far enough (|sin| of the turn, scaled
+        // by the axis lengths), shifting the value so that it does not jump.
+        const int64_t cross = (state.axisX * state.latchY - state.axisY * state.latchX) >> 15;
+        const bool relatch = (cross < 0 ? -cross : cross) > params.axisTolerance;
+        const int64_t before = (x * state.latchX + y * state.latchY) >> 15;
+        state.latchX = relatch ? state.axisX : state.latchX;
+        state.latchY = relatch ? state.axisY : state.latchY;
+        const int64_t after = (x * state.latchX + y * state.latchY) >> 15;
+        state.offset += relatch ? before - after : 0;
+        const int64_t value = after + state.offset;
+        const int64_t delta = value - state.lastValue;
+        direction = state.primed ? (delta > 0) - (delta < 0) : 0;
+        state.lastValue = value;
+        state.primed = true;
+        return value;
+    }
+
+    /**
+     * @brief Get the current centre of the motion.
+     */
+    int64_t getCenterX() const {
+        return m_state.centerX >> m_params.baselineShift;
+    }
+
+    /**
+     * @brief Get the current centre of the motion.
+     */
+    int64_t getCenterY() const {
+        return m_state.centerY >> m_params.baselineShift;
+    }
+
+    /**
+     * @brief Get the estimated axis of motion in degrees, in (-90, 90].
+     */
+    float getAxisAngle() const {
+        const float angle = std::atan2(static_cast<float>(m_state.axisY), static_cast<float>(m_state.axisX)) * 57.2957795f;
+        return angle > 90.0f ? angle - 180.0f : (angle <= -90.0f ? angle + 180.0f : angle);
+    }
+
+    /**
+     * @brief Get a copy of the front-end state.
+     */
+    PlanarOscillatorState getState() const {
+        return m_state;
+    }
+
+    /**
+     * @brief Get the detector that runs on the reduced signal, e.g. to set its sensitivity.
+     */
+    OscillatorDetector& getDetector() {
+        return m_detector;
+    }
+
+    /**
+     * @brief Get the detector that runs on the reduced signal.
+     */
+    const OscillatorDetector& getDetector() const {
+        return m_detector;
+    }
+
+    /**
+     * @brief Set the centre EMA weight; takes effect with the next sample.
+     * @param shift The weight of a new sample is 2^-shift, in [0, 30].
+     */
+    void setBaselineShift(uint8_t shift) {
+        m_state.centerX = (m_state.centerX >> m_params.baselineShift) * (int64_t{ 1 } << shift);
+        m_state.centerY = (m_state.centerY >> m_params.baselineShift) * (int64_t{ 1 } << shift);
+        m_params.baselineShift = shift;
+    }
+
+    /**
+     * @brief Set the covariance EMA weight of the principal-axis estimate.
+     * @param shift The weight of a new sample is 2^-shift.
+     */
+    void setCovarianceShift(uint8_t shift) {
+        m_params.covarianceShift = shift;
+    }
+
+    /**
+     * @brief Set how far the axis estimate may turn before the projection follows it.
+     * @param tolerance Sine of the turn in Q15 units, see PlanarOscillatorParams::axisTolerance.
+     */
+    void setAxisTolerance(int64_t tolerance) {
+        m_params.axisTolerance = tolerance;
+    }
+
+    /**
+     * @brief Get the centre EMA weight.
+     */
+    uint8_t getBaselineShift() const {
+        return m_params.baselineShift;
+    }
+
+    /**
+     * @brief Get the covariance EMA weight.
+     */
+    uint8_t getCovarianceShift() const {
+        return m_params.covarianceShift;
+    }
+
+    /**
+     * @brief Get the axis tolerance.
+     */
+    int64_t getAxisTolerance() const {
+        return m_params.axisTolerance;
+    }
+
+private:
+    // |value| in uint64_t, so INT64_MIN does not overflow.
+    static uint64_t magnitude(int64_t value) {
+        const uint64_t bits = static_cast<uint64_t>(value);
+        return value < 0 ? 0 - bits : bits;
+    }
+
+    static int bitWidth(uint64_t value) {
+        return static_cast<int>(std::bit_width(value));
+    }
+
+    // value * 2^-scale, shifting left for negative scales to keep small covariances precise.
+    static int64_t normalize(int64_t value, int scale) {
+        return scale > 0 ? value >> scale : value * (int64_t{ 1 } << -scale);
+    }
+
+    PlanarOscillatorParams m_params;
+    PlanarOscillatorState m_state;
+    OscillatorDetector m_detector;
+};
+
+
+/**
+ * @brief A set of PlanarOscillatorDetector channels updated together.
+ *
+ * The front-end state is kept in one array per field and the projection loop
+ * over all channels is branch-free; its output frame then drives an
+ * OscillatorDetectorBank. The projection runs scalar: GCC does not vectorize
+ * its 64-bit multiplies and per-channel shifts (checked with -fopt-info-vec).
+ */
+class PlanarOscillatorDetectorBank {
+public:
+    explicit PlanarOscillatorDetectorBank(std::size_t channels)
+        : m_channels(channels)
+        , m_centerX(channels, 0)
+        , m_centerY(channels, 0)
+        , m_covarianceXX(channels, 0)
+        , m_covarianceYY(channels, 0)
+        , m_covarianceXY(channels, 0)
+        , m_axisX(channels, PlanarOscillatorState{}.axisX)
+        , m_axisY(channels, PlanarOscillatorState{}.axisY)
+        , m_latchX(channels, PlanarOscillatorState{}.latchX)
+        , m_latchY(channels, PlanarOscillatorState{}.latchY)
+        , m_offset(channels, 0)
+        , m_lastValue(channels, 0)
+        , m_values(channels)
+        , m_directions(channels)
+        , m_detectors(channels) {}
+
+    /**
+     * @brief Get the number of channels.
+     */
+    std::size_t size() const {
+        return m_channels;
+    }
+
+    /**
+     * @brief Update every channel with its current position.
+     * @param xs, ys One coordinate pair per channel.
+     * @param events Receives the OscillatorEvent flags of each channel; may be nullptr.
+     */
+    void update(const int64_t* xs, const int64_t* ys, uint8_t* events) {
+        const PlanarOscillatorParams params = m_params;
+        const bool primed = m_primed;
+        int64_t* centerX = m_centerX.data();
+        int64_t* centerY = m_centerY.data();
+        int64_t* covarianceXX = m_covarianceXX.data();
+        int64_t* covarianceYY = m_covarianceYY.data();
+        int64_t* covarianceXY = m_covarianceXY.data();
+        int64_t* axisX = m_axisX.data();
+        int64_t* axisY = m_axisY.data();
+        int64_t* latchX = m_latchX.data();
+        int64_t* latchY = m_latchY.data();
+        int64_t* offset = m_offset.data();
+        int64_t* lastValue = m_lastValue.data();
+        int64_t* values = m_values.data();
+        int8_t* directions = m_directions.data();
+        const std::size_t channels = m_channels;
+        for (std::size_t channel = 0; channel < channels; ++channel) {
+            PlanarOscillatorState state{ centerX[channel], centerY[channel], covarianceXX[channel], covarianceYY[channel],
+                                         covarianceXY[channel], axisX[channel], axisY[channel], latchX[channel], latchY[channel],
+                                         offset[channel], lastValue[channel], primed };
+            int direction = 0;
+            values[channel] = PlanarOscillatorDetector::project(params, state, xs[channel], ys[channel], direction);
+            directions[channel] = static_cast<int8_t>(direction);
+            centerX[channel] = state.centerX;
+            centerY[channel] = state.centerY;
+            covarianceXX[channel] = state.covarianceXX;
+            covarianceYY[channel] = state.covarianceYY;
+            covarianceXY[channel] = state.covarianceXY;
+            axisX[channel] = state.axisX;
+            axisY[channel] = state.axisY;
+            latchX[channel] = state.latchX;
+            latchY[channel] = state.latchY;
+            offset[channel] = state.offset;
+            lastValue[channel] = state.lastValue;
+        }
+        m_primed = true;
+        m_detectors.update(m_values.data(), m_directions.data(), events);
+    }
+
+    /**
+     * @brief Reset every channel to the initial state.
+     */
+    void reset() {
+        std::fill(m_centerX.begin(), m_centerX.end(), 0);
+        std::fill(m_centerY.begin(), m_centerY.end(), 0);
+        std::fill(m_covarianceXX.begin(), m_covarianceXX.end(), 0);
+        std::fill(m_covarianceYY.begin(), m_covarianceYY.end(), 0);
+        std::fill(m_covarianceXY.begin(), m_covarianceXY.end(), 0);
+        std::fill(m_axisX.begin(), m_axisX.end(), PlanarOscillatorState{}.axisX);
+        std::fill(m_axisY.begin(), m_axisY.end(), PlanarOscillatorState{}.axisY);
+        std::fill(m_latchX.begin(), m_latchX.end(), PlanarOscillatorState{}.latchX);
+        std::fill(m_latchY.begin(), m_latchY.end(), PlanarOscillatorState{}.latchY);
+        std::fill(m_offset.begin(), m_offset.end(), 0);
+        std::fill(m_lastValue.begin(), m_lastValue.end(), 0);
+        m_detectors.reset();
+        m_primed = false;
+    }
+
+    /**
+     * @brief Get a copy of the front-end state of one channel.
+     */
+    PlanarOscillatorState getState(std::size_t channel) const {
+        return { m_centerX[channel], m_centerY[channel], m_covarianceXX[channel], m_covarianceYY[channel],
+                 m_covarianceXY[channel], m_axisX[channel], m_axisY[channel], m_latchX[channel], m_latchY[channel],
+                 m_offset[channel], m_lastValue[channel], m_primed };
+    }
+
+    /**
+     * @brief Get the detector bank that runs on the reduced signals, e.g. to set the sensitivity or rank channels.
+     */
+    OscillatorDetectorBank& getDetectors() {
+        return m_detectors;
+    }
+
+    /**
+     * @brief Get the detector bank that runs on the reduced signals.
+     */
+    const OscillatorDetectorBank& getDetectors() const {
+        return m_detectors;
+    }
+
+    /**
+     * @brief Set the centre EMA weight of all channels, see PlanarOscillatorDetector.
+     */
+    void setBaselineShift(uint8_t shift) {
+        for (std::size_t channel = 0; channel < m_channels; ++channel) {
+            m_centerX[channel] = (m_centerX[channel] >> m_params.baselineShift) * (int64_t{ 1 } << shift);
+            m_centerY[channel] = (m_centerY[channel] >> m_params.baselineShift) * (int64_t{ 1 } << shift);
+        }
+        m_params.baselineShift = shift;
+    }
+
+    /**
+     * @brief Set the covariance EMA weight of all channels.
+     */
+    void setCovarianceShift(uint8_t shift) {
+        m_params.covarianceShift = shift;
+    }
+
+    /**
+     * @brief Set the axis tolerance of all channels, see PlanarOscillatorDetector.
+     */
+    void setAxisTolerance(int64_t tolerance) {
+        m_params.axisTolerance = tolerance;
+    }
+
+    /**
+     * @brief Get the centre EMA weight.
+     */
+    uint8_t getBaselineShift() const {
+        return m_params.baselineShift;
+    }
+
+    /**
+     * @brief Get the covariance EMA weight.
+     */
+    uint8_t getCovarianceShift() const {
+        return m_params.covarianceShift;
+    }
+
+    /**
+     * @brief Get the axis tolerance.
+     */
+    int64_t getAxisTolerance() const {
+        return m_params.axisTolerance;
+    }
+
+private:
+    std::size_t m_channels;
+    std::vector<int64_t> m_centerX;
+    std::vector<int64_t> m_centerY;
+    std::vector<int64_t> m_covarianceXX;
+    std::vector<int64_t> m_covarianceYY;
+    std::vector<int64_t> m_covarianceXY;
+    std::vector<int64_t> m_axisX;
+    std::vector<int64_t> m_axisY;
+    std::vector<int64_t> m_latchX;
+    std::vector<int64_t> m_latchY;
+    std::vector<int64_t> m_offset;
+    std::vector<int64_t> m_lastValue;
+    std::vector<int64_t> m_values;      // reduced frame passed to m_detectors
+    std::vector<int8_t> m_directions;
+    OscillatorDetectorBank m_detectors;
+    PlanarOscillatorParams m_params;
+    bool m_primed = false;
+};
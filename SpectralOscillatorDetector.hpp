@@ -0,0 +1,463 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2025, Szymon Bandel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "OscillatorDetector.hpp"
+#include "OscillatorDetectorBank.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/**
+ * @brief Parameters of the spectral engine, shared by all channels of a bank.
+ *
+ * Every target frequency is followed by a sliding Goertzel filter with an
+ * exponential window: a two-pole resonator whose poles lie at radius
+ * r = 1 - 1 / window. The window (in samples) sets both the memory and the
+ * bandwidth (about 1 / (pi * window) cycles per sample) of each filter.
+ */
+struct SpectralOscillatorParams {
+    std::vector<float> frequencies; ///< Target frequencies in cycles per sample, (0, 0.5).
+    uint32_t window = 256;          ///< Time constant of the sliding window in samples.
+    float threshold = 0.2f;         ///< Share of the signal power in one filter that counts as an oscillation.
+
+    // Derived per filter / per window; see prepare().
+    std::vector<float> coefficients;  ///< 2 r cos(2 pi f)
+    float decay = 0.0f;               ///< r
+    float decaySquared = 0.0f;        ///< r^2
+    float normalization = 0.0f;       ///< 2 (1 - r): a pure tone at a target frequency has concentration 1
+
+    void prepare() {
+        const float r = 1.0f - 1.0f / static_cast<float>(std::max<uint32_t>(window, 2));
+        decay = r;
+        decaySquared = r * r;
+        normalization = 2.0f * (1.0f - r);
+        coefficients.resize(frequencies.size());
+        for (std::size_t k = 0; k < frequencies.size(); ++k) {
+            coefficients[k] = 2.0f * r * static_cast<float>(std::cos(2.0 * 3.14159265358979 * frequencies[k]));
+        }
+    }
+};
+
+
+/**
+ * @brief Oscillation detector based on the signal spectrum instead of extrema.
+ *
+ * An alternative engine for heavily noisy signals, where extremum counting
+ * breaks down: a bank of sliding Goertzel filters at configurable target
+ * frequencies measures how much of the (mean-free) signal power falls into
+ * each filter. A pure tone at a target frequency has a concentration close to
+ * 1, white noise about 1 / window. An oscillation is detected when the
+ * strongest filter reaches the threshold after one window of samples.
+ *
+ * The cost per sample is one multiply-add recursion per target frequency, with
+ * constant state; no sample history and no FFT. The interface mirrors
+ * OscillatorDetector (detect(), update(), getScore()) so both engines can be
+ * used interchangeably; the direction argument is not needed and ignored.
+ */
+class SpectralOscillatorDetector {
+public:
+    /**
+     * @param frequencies Target frequencies in cycles per sample.
+     * @param window Time constant of the sliding window in samples.
+     */
+    explicit SpectralOscillatorDetector(std::vector<float> frequencies = { 1.0f / 64.0f }, uint32_t window = 256) {
+        m_params.frequencies = std::move(frequencies);
+        m_params.window = window;
+        configure();
+    }
+
+    /**
+     * @brief Detect an oscillation at one of the target frequencies.
+     * @param position The current value of the signal.
+     * @param direction Ignored; kept for interface compatibility with OscillatorDetector.
+     * @return true if the strongest filter holds at least the threshold share of the signal power.
+     */
+    bool detect(int64_t position, int direction) {
+        return (update(position, direction) & OscillatorEvent::Detected) != 0;
+    }
+
+    /**
+     * @brief Same as detect(), but returns OscillatorEvent flags (only Detected is used).
+     */
+    uint8_t update(int64_t position, int /*direction*/) {
+        const float deviation = track(m_params, position, m_samples == 0, m_baseline, m_mean, m_energy);
+        const float scale = m_params.normalization / (m_energy + 1e-30f);
+        float best = 0.0f;
+        for (std::size_t k = 0; k < m_first.size(); ++k) {
+            const float power = resonate(m_params.coefficients[k], m_params.decaySquared, deviation, m_first[k], m_second[k]);
+            m_concentration[k] = power * scale;
+            best = std::max(best, m_concentration[k]);
+        }
+        m_best = best;
+        m_samples += m_samples < m_params.window;
+        return detected(m_params, m_samples, best) ? OscillatorEvent::Detected : 0;
+    }
+
+    /**
+     * @brief Forget the signal history.
+     */
+    void reset() {
+        std::fill(m_first.begin(), m_first.end(), 0.0f);
+        std::fill(m_second.begin(), m_second.end(), 0.0f);
+        std::fill(m_concentration.begin(), m_concentration.end(), 0.0f);
+        m_mean = 0.0f;
+        m_energy = 0.0f;
+        m_best = 0.0f;
+        m_samples = 0;
+    }
+
+    /**
+     * @brief Share of the signal power in one filter, in [0, ~1].
+     * @param k Index into the target frequencies.
+     */
+    float getConcentration(std::size_t k) const {
+        return m_concentration[k];
+    }
+
+    /**
+     * @brief Index of the target frequency with the highest concentration.
+     */
+    std::size_t getDominantFrequency() const {
+        return static_cast<std::size_t>(std::max_element(m_concentration.begin(), m_concentration.end()) - m_concentration.begin());
+    }
+
+    /**
+     * @brief Confidence score comparable to OscillatorDetector::getScore(): the best concentration scaled to 65535.
+     */
+    uint16_t getScore() const {
+        return score(m_best);
+    }
+
+    /**
+     * @brief Set the target frequencies; resets the detector.
+     * @param frequencies Frequencies in cycles per sample.
+     */
+    void setFrequencies(std::vector<float> frequencies) {
+        m_params.frequencies = std::move(frequencies);
+        configure();
+    }
+
+    /**
+     * @brief Set the time constant of the sliding window; resets the detector.
+     * @param samples Window length in samples.
+     */
+    void setWindow(uint32_t samples) {
+        m_params.window = samples;
+        configure();
+    }
+
+    /**
+     * @brief Set the concentration needed for a detection.
+     * @param threshold Share of the signal power, in (0, 1).
+     */
+    void setThreshold(float threshold) {
+        m_params.threshold = threshold;
+    }
+
+    /**
+     * @brief Get the target frequencies.
+     */
+    const std::vector<float>& getFrequencies() const {
+        return m_params.frequencies;
+    }
+
+    /**
+     * @brief Get the time constant of the sliding window.
+     */
+    uint32_t getWindow() const {
+        return m_params.window;
+    }
+
+    /**
+     * @brief Get the detection threshold.
+     */
+    float getThreshold() const {
+        return m_params.threshold;
+    }
+
+    // Kernel pieces shared with SpectralOscillatorDetectorBank, so a bank
+    // channel computes exactly what a standalone detector does.
+
+    /**
+     * @brief Update the running mean and power of the signal.
+     *
+     * The mean is an integer baseline plus a float remainder. Positions are
+     * offset by the baseline in 64-bit integers before they are converted, so
+     * the float math keeps its precision far away from zero. The baseline
+     * starts at the first sample and takes over the whole part of the mean on
+     * every update.
+     * @param first true for the first sample after a reset.
+     * @return The mean-free sample that feeds the filters.
+     */
+    static float track(const SpectralOscillatorParams& params, int64_t position, bool first,
+                       int64_t& baseline, float& mean, float& energy) {
+        baseline = first ? position : baseline;
+        const float x = static_cast<float>(static_cast<int64_t>(static_cast<uint64_t>(position) - static_cast<uint64_t>(baseline)));
+        mean += (1.0f - params.decay) * (x - mean);
+        const float deviation = x - mean;
+        energy = params.decay * energy + deviation * deviation;
+        const int64_t whole = static_cast<int64_t>(mean);
+        baseline = static_cast<int64_t>(static_cast<uint64_t>(baseline) + static_cast<uint64_t>(whole));
+        mean -= static_cast<float>(whole);
+        return deviation;
+    }
+
+    /**
+     * @brief One Goertzel step with pole radius r.
+     *
+     * s[n] = x + 2 r cos(w) s[n-1] - r^2 s[n-2]; the filter output
+     * y = s[n] - r e^(-jw) s[n-1] has |y|^2 = s[n]^2 + r^2 s[n-1]^2 - 2 r cos(w) s[n] s[n-1].
+     * @return |y|^2
+     */
+    static float resonate(float coefficient, float decaySquared, float x, float& first, float& second) {
+        const float next = x + coefficient * first - decaySquared * second;
+        second = first;
+        first = next;
+        return first * first + decaySquared * second * second - coefficient * first * second;
+    }
+
+    static bool detected(const SpectralOscillatorParams& params, uint32_t samples, float best) {
+        return (samples >= params.window) & (best >= params.threshold);
+    }
+
+    static uint16_t score(float best) {
+        return static_cast<uint16_t>(std::min(best, 1.0f) * 65535.0f);
+    }
+
+private:
+    void configure() {
+        m_params.prepare();
+        m_first.assign(m_params.frequencies.size(), 0.0f);
+        m_second.assign(m_params.frequencies.size(), 0.0f);
+        m_concentration.assign(m_params.frequencies.size(), 0.0f);
+        reset();
+    }
+
+    SpectralOscillatorParams m_params;
+    std::vector<float> m_first;         // s[n-1] per filter
+    std::vector<float> m_second;        // s[n-2] per filter
+    std::vector<float> m_concentration;
+    int64_t m_baseline = 0;             // integer part of the running mean
+    float m_mean = 0.0f;                // remainder of the running mean
+    float m_energy = 0.0f;
+    float m_best = 0.0f;
+    uint32_t m_samples = 0;             // saturates at the window length
+};
+
+
+/**
+ * @brief A set of SpectralOscillatorDetector channels updated together.
+ *
+ * Same interface as BasicOscillatorDetectorBank, so a channel class can use
+ * whichever engine is cheaper. The filter state is stored frequency-major
+ * (one contiguous array of channels per target frequency), so every step is a
+ * straight loop over channels that the compiler vectorizes; the loop over
+ * frequencies is outside.
+ */
+class SpectralOscillatorDetectorBank {
+public:
+    /**
+     * @param channels Number of channels.
+     * @param frequencies Target frequencies in cycles per sample, shared by all channels.
+     * @param window Time constant of the sliding window in samples.
+     */
+    SpectralOscillatorDetectorBank(std::size_t channels, std::vector<float> frequencies = { 1.0f / 64.0f }, uint32_t window = 256)
+        : m_channels(channels) {
+        m_params.frequencies = std::move(frequencies);
+        m_params.window = window;
+        configure();
+    }
+
+    /**
+     * @brief Get the number of channels.
+     */
+    std::size_t size() const {
+        return m_channels;
+    }
+
+    /**
+     * @brief Update every channel with its current sample.
+     *
+     * @param positions One signal value per channel.
+     * @param directions Ignored; kept for interface compatibility with OscillatorDetectorBank.
+     * @param events Receives the OscillatorEvent flags of each channel; may be nullptr.
+     */
+    void update(const int64_t* positions, const int8_t* /*directions*/, uint8_t* events) {
+        const SpectralOscillatorParams& params = m_params;
+        const std::size_t n = m_channels;
+        float* deviation = m_deviation.data();
+        float* scale = m_scale.data();
+        float* best = m_best.data();
+        int64_t* baseline = m_baseline.data();
+        float* mean = m_mean.data();
+        float* energy = m_energy.data();
+        const bool primeBaseline = m_samples == 0;
+
+        for (std::size_t c = 0; c < n; ++c) {
+            deviation[c] = SpectralOscillatorDetector::track(params, positions[c], primeBaseline, baseline[c], mean[c], energy[c]);
+            scale[c] = params.normalization / (energy[c] + 1e-30f);
+            best[c] = 0.0f;
+        }
+        for (std::size_t k = 0; k < params.coefficients.size(); ++k) {
+            const float coefficient = params.coefficients[k];
+            float* first = m_first.data() + k * n;
+            float* second = m_second.data() + k * n;
+            for (std::size_t c = 0; c < n; ++c) {
+                const float power = SpectralOscillatorDetector::resonate(coefficient, params.decaySquared, deviation[c], first[c], second[c]);
+                best[c] = std::max(best[c], power * scale[c]);
+            }
+        }
+        m_samples += m_samples < params.window;
+
+        if (events) {
+            for (std::size_t c = 0; c < n; ++c) {
+                events[c] = SpectralOscillatorDetector::detected(params, m_samples, best[c]) ? OscillatorEvent::Detected : 0;
+            }
+        }
+    }
+
+    /**
+     * @brief Reset every channel to the initial state.
+     */
+    void reset() {
+        std::fill(m_first.begin(), m_first.end(), 0.0f);
+        std::fill(m_second.begin(), m_second.end(), 0.0f);
+        std::fill(m_mean.begin(), m_mean.end(), 0.0f);
+        std::fill(m_energy.begin(), m_energy.end(), 0.0f);
+        std::fill(m_best.begin(), m_best.end(), 0.0f);
+        m_samples = 0;
+    }
+
+    /**
+     * @brief Get the confidence score of one channel, see SpectralOscillatorDetector::getScore().
+     */
+    uint16_t getScore(std::size_t channel) const {
+        return SpectralOscillatorDetector::score(m_best[channel]);
+    }
+
+    /**
+     * @brief Compute the confidence score of every channel.
+     * @param scores Receives size() scores.
+     */
+    void computeScores(uint16_t* scores) const {
+        for (std::size_t channel = 0; channel < m_channels; ++channel) {
+            scores[channel] = getScore(channel);
+        }
+    }
+
+    /**
+     * @brief Find the k channels with the highest confidence score, see OscillatorDetectorBank::topK().
+     */
+    std::size_t topK(std::size_t k, uint32_t* channels) const {
+        m_scores.resize(m_channels);
+        computeScores(m_scores.data());
+        return OscillatorDetectorBank::selectTopK(m_scores.data(), m_channels, k, channels);
+    }
+
+    /**
+     * @brief Set the target frequencies of all channels; resets the bank.
+     */
+    void setFrequencies(std::vector<float> frequencies) {
+        m_params.frequencies = std::move(frequencies);
+        configure();
+    }
+
+    /**
+     * @brief Set the time constant of the sliding window; resets the bank.
+     */
+    void setWindow(uint32_t samples) {
+        m_params.window = samples;
+        configure();
+    }
+
+    /**
+     * @brief Set the concentration needed for a detection, see SpectralOscillatorDetector.
+     */
+    void setThreshold(float threshold) {
+        m_params.threshold = threshold;
+    }
+
+    /**
+     * @brief Get the target frequencies.
+     */
+    const std::vector<float>& getFrequencies() const {
+        return m_params.frequencies;
+    }
+
+    /**
+     * @brief Get the time constant of the sliding window.
+     */
+    uint32_t getWindow() const {
+        return m_params.window;
+    }
+
+    /**
+     * @brief Get the detection threshold.
+     */
+    float getThreshold() const {
+        return m_params.threshold;
+    }
+
+private:
+    void configure() {
+        m_params.prepare();
+        m_first.assign(m_params.frequencies.size() * m_channels, 0.0f);
+        m_second.assign(m_params.frequencies.size() * m_channels, 0.0f);
+        m_baseline.assign(m_channels, 0);
+        m_mean.assign(m_channels, 0.0f);
+        m_energy.assign(m_channels, 0.0f);
+        m_best.assign(m_channels, 0.0f);
+        m_deviation.assign(m_channels, 0.0f);
+        m_scale.assign(m_channels, 0.0f);
+        m_samples = 0;
+    }
+
+    std::size_t m_channels;
+    SpectralOscillatorParams m_params;
+    std::vector<float> m_first;     // frequency-major: [k * channels + c]
+    std::vector<float> m_second;
+    std::vector<int64_t> m_baseline; // integer part of the running mean
+    std::vector<float> m_mean;      // remainder
+    std::vector<float> m_energy;
+    std::vector<float> m_best;      // best concentration of the last update
+    std::vector<float> m_deviation; // scratch
+    std::vector<float> m_scale;     // scratch
+    uint32_t m_samples = 0;
+    mutable std::vector<uint16_t> m_scores;
+};
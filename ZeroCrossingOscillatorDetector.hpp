@@ -0,0 +1,486 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2025, Szymon Bandel
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "OscillatorDetector.hpp"
+#include "OscillatorDetectorBank.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+
+/**
+ * @brief Parameters of the zero-crossing engine, shared by all channels of a bank.
+ */
+struct ZeroCrossingParams {
+    uint8_t baselineShift = 6;  ///< Baseline EMA weight 2^-shift (6: time constant of 64 samples).
+    int64_t hysteresis = 0;     ///< Half width of the band around the baseline that does not change sides.
+    uint8_t sensitivity = 5;    ///< Crossings needed for a detection (more than this many).
+    uint16_t timeout = 1000;    ///< Samples without a crossing after which the count restarts.
+};
+
+/**
+ * @brief Per-channel state of the zero-crossing engine.
+ */
+struct ZeroCrossingState {
+    int64_t accumulator = 0;            ///< Baseline << baselineShift.
+    int8_t side = 0;                    ///< -1 below, 1 above the band; 0 until the signal first leaves it.
+    bool primed = false;                ///< The baseline has been initialized with the first sample.
+    uint8_t crossingCounter = 0;
+    uint16_t samplesSinceCrossing = 0;
+};
+
+
+/**
+ * @brief Oscillation detector that counts crossings of a moving baseline.
+ *
+ * For signals that oscillate around a drifting setpoint: the baseline is an
+ * exponential moving average of the signal, and a crossing is counted when the
+ * signal moves from one side of the band baseline +- hysteresis to the other.
+ * An oscillation is detected when more than `sensitivity` crossings occur
+ * with no gap longer than `timeout` samples.
+ *
+ * The interface mirrors OscillatorDetector: update() returns OscillatorEvent
+ * flags, with every counted crossing reported as an Extremum and a timeout
+ * that drops a count reported as a Reset. The direction argument is not needed
+ * and is ignored. All arithmetic is integer; positions must stay within
+ * +-2^(62 - baselineShift).
+ */
+class ZeroCrossingOscillatorDetector {
+public:
+    /**
+     * @brief Detect an oscillation around the tracked baseline.
+     * @param position The current value of the signal.
+     * @param direction Ignored; kept for interface compatibility with OscillatorDetector.
+     * @return true if more than `sensitivity` crossings were counted.
+     */
+    bool detect(int64_t position, int direction) {
+        return (update(position, direction) & OscillatorEvent::Detected) != 0;
+    }
+
+    /**
+     * @brief Same as detect(), but reports everything that happened during the update.
+     * @return A combination of OscillatorEvent flags.
+     */
+    uint8_t update(int64_t position, int /*direction*/) {
+        return step(m_params, m_state, position);
+    }
+
+    /**
+     * @brief One update of a channel; the kernel shared with ZeroCrossingOscillatorDetectorBank.
+     * @return A combination of OscillatorEvent flags.
+     */
+    static uint8_t step(const ZeroCrossingParams& params, ZeroCrossingState& state, int64_t position) {
+        const int shift = params.baselineShift;
+        state.accumulator = state.primed
+            ? state.accumulator + position - (state.accumulator >> shift)
+            : position * (int64_t{ 1 } << shift);
+        state.primed = true;
+
+        const int64_t deviation = position - (state.accumulator >> shift);
+        const bool above = deviation > params.hysteresis;
+        const bool below = deviation < -params.hysteresis;
+        const int8_t side = above ? 1 : (below ? -1 : state.side);
+        const bool crossed = (state.side != 0) & (side != state.side);
+        state.side = side;
+
+        const int counter = std::min(state.crossingCounter + static_cast<int>(crossed), 255);
+        const int since = crossed ? 0 : std::min(state.samplesSinceCrossing + 1, 65535);
+        const bool timedOut = since > params.timeout;
+        const bool reset = timedOut & (counter > 0);
+        state.crossingCounter = static_cast<uint8_t>(timedOut ? 0 : counter);
+        state.samplesSinceCrossing = static_cast<uint16_t>(since);
+
+        const bool detected = state.crossingCounter > params.sensitivity;
+        return static_cast<uint8_t>(detected * OscillatorEvent::Detected
+            | crossed * OscillatorEvent::Extremum
+            | reset * OscillatorEvent::Reset);
+    }
+
+    /**
+     * @brief Confidence score comparable to OscillatorDetector::score() for a steady oscillation.
+     */
+    static uint16_t score(const ZeroCrossingParams& params, const ZeroCrossingState& state) {
+        const int limit = params.sensitivity + 1;
+        return static_cast<uint16_t>(std::min<int>(state.crossingCounter, limit) * 49151 / limit);
+    }
+
+    /**
+     * @brief Get the current baseline.
+     */
+    int64_t getBaseline() const {
+        return m_state.accumulator >> m_params.baselineShift;
+    }
+
+    /**
+     * @brief Get the graded oscillation confidence, see score().
+     */
+    uint16_t getScore() const {
+        return score(m_params, m_state);
+    }
+
+    /**
+     * @brief Get a copy of the internal state.
+     */
+    ZeroCrossingState getState() const {
+        return m_state;
+    }
+
+    /**
+     * @brief Set the baseline EMA weight; takes effect with the next sample.
+     * @param shift The weight of a new sample is 2^-shift, in [0, 30].
+     */
+    void setBaselineShift(uint8_t shift) {
+        m_state.accumulator = (m_state.accumulator >> m_params.baselineShift) * (int64_t{ 1 } << shift);
+        m_params.baselineShift = shift;
+    }
+
+    /**
+     * @brief Set the half width of the band around the baseline.
+     * @param hysteresis Deviation needed to change sides, in signal units.
+     */
+    void setHysteresis(int64_t hysteresis) {
+        m_params.hysteresis = hysteresis;
+    }
+
+    /**
+     * @brief Set the sensitivity threshold for oscillation detection.
+     * @param sensitivity Number of crossings needed to signal an oscillation.
+     */
+    void setSensitivity(uint8_t sensitivity) {
+        m_params.sensitivity = sensitivity;
+    }
+
+    /**
+     * @brief Set the longest gap between crossings of one oscillation.
+     * @param samples Gap after which the count restarts.
+     */
+    void setTimeout(uint16_t samples) {
+        m_params.timeout = samples;
+    }
+
+    /**
+     * @brief Get the baseline EMA weight.
+     */
+    uint8_t getBaselineShift() const {
+        return m_params.baselineShift;
+    }
+
+    /**
+     * @brief Get the half width of the band around the baseline.
+     */
+    int64_t getHysteresis() const {
+        return m_params.hysteresis;
+    }
+
+    /**
+     * @brief Get the current sensitivity threshold.
+     */
+    uint8_t getSensitivity() const {
+        return m_params.sensitivity;
+    }
+
+    /**
+     * @brief Get the longest gap between crossings of one oscillation.
+     */
+    uint16_t getTimeout() const {
+        return m_params.timeout;
+    }
+
+private:
+    ZeroCrossingParams m_params;
+    ZeroCrossingState m_state;
+};
+
+
+/**
+ * @brief A set of ZeroCrossingOscillatorDetector channels updated together.
+ *
+ * Same interface as BasicOscillatorDetectorBank. Every state field is kept in
+ * its own int64 array (32 bytes per channel), so one AVX2 register holds one
+ * field of four channels; the kernel is the same as
+ * ZeroCrossingOscillatorDetector::step() written with 64-bit vector compares
+ * and selects. The first update, the last partial group of channels and
+ * builds without AVX2 use the scalar kernel.
+ */
+class ZeroCrossingOscillatorDetectorBank {
+public:
+    explicit ZeroCrossingOscillatorDetectorBank(std::size_t channels)
+        : m_channels(channels)
+        , m_accumulator(channels, 0)
+        , m_side(channels, 0)
+        , m_crossingCounter(channels, 0)
+        , m_samplesSinceCrossing(channels, 0) {}
+
+    /**
+     * @brief Get the number of channels.
+     */
+    std::size_t size() const {
+        return m_channels;
+    }
+
+    /**
+     * @brief Update every channel with its current sample.
+     *
+     * @param positions One signal value per channel.
+     * @param directions Ignored; kept for interface compatibility with OscillatorDetectorBank.
+     * @param events Receives the OscillatorEvent flags of each channel; may be nullptr.
+     */
+    void update(const int64_t* positions, const int8_t* /*directions*/, uint8_t* events) {
+        std::size_t channel = 0;
+#if defined(__AVX2__)
+        if (m_primed) {
+            channel = updateAvx2(positions, events);
+        }
+#endif
+        for (; channel < m_channels; ++channel) {
+            ZeroCrossingState state = load(channel);
+            const uint8_t flags = ZeroCrossingOscillatorDetector::step(m_params, state, positions[channel]);
+            store(channel, state);
+            if (events) {
+                events[channel] = flags;
+            }
+        }
+        m_primed = true;
+    }
+
+    /**
+     * @brief Reset every channel to the initial state.
+     */
+    void reset() {
+        std::fill(m_accumulator.begin(), m_accumulator.end(), 0);
+        std::fill(m_side.begin(), m_side.end(), 0);
+        std::fill(m_crossingCounter.begin(), m_crossingCounter.end(), 0);
+        std::fill(m_samplesSinceCrossing.begin(), m_samplesSinceCrossing.end(), 0);
+        m_primed = false;
+    }
+
+    /**
+     * @brief Get a copy of the state of one channel.
+     */
+    ZeroCrossingState getState(std::size_t channel) const {
+        return load(channel);
+    }
+
+    /**
+     * @brief Get the confidence score of one channel, see ZeroCrossingOscillatorDetector::score().
+     */
+    uint16_t getScore(std::size_t channel) const {
+        return ZeroCrossingOscillatorDetector::score(m_params, load(channel));
+    }
+
+    /**
+     * @brief Compute the confidence score of every channel.
+     * @param scores Receives size() scores.
+     */
+    void computeScores(uint16_t* scores) const {
+        for (std::size_t channel = 0; channel < m_channels; ++channel) {
+            scores[channel] = getScore(channel);
+        }
+    }
+
+    /**
+     * @brief Find the k channels with the highest confidence score, see OscillatorDetectorBank::topK().
+     */
+    std::size_t topK(std::size_t k, uint32_t* channels) const {
+        m_scores.resize(m_channels);
+        computeScores(m_scores.data());
+        return OscillatorDetectorBank::selectTopK(m_scores.data(), m_channels, k, channels);
+    }
+
+    /**
+     * @brief Set the baseline EMA weight of all channels, see ZeroCrossingOscillatorDetector.
+     */
+    void setBaselineShift(uint8_t shift) {
+        for (int64_t& accumulator : m_accumulator) {
+            accumulator = (accumulator >> m_params.baselineShift) * (int64_t{ 1 } << shift);
+        }
+        m_params.baselineShift = shift;
+    }
+
+    /**
+     * @brief Set the half width of the band around the baseline of all channels.
+     */
+    void setHysteresis(int64_t hysteresis) {
+        m_params.hysteresis = hysteresis;
+    }
+
+    /**
+     * @brief Set the sensitivity of all channels.
+     */
+    void setSensitivity(uint8_t sensitivity) {
+        m_params.sensitivity = sensitivity;
+    }
+
+    /**
+     * @brief Set the longest gap between crossings of all channels.
+     */
+    void setTimeout(uint16_t samples) {
+        m_params.timeout = samples;
+    }
+
+    /**
+     * @brief Get the baseline EMA weight.
+     */
+    uint8_t getBaselineShift() const {
+        return m_params.baselineShift;
+    }
+
+    /**
+     * @brief Get the half width of the band around the baseline.
+     */
+    int64_t getHysteresis() const {
+        return m_params.hysteresis;
+    }
+
+    /**
+     * @brief Get the current sensitivity threshold.
+     */
+    uint8_t getSensitivity() const {
+        return m_params.sensitivity;
+    }
+
+    /**
+     * @brief Get the longest gap between crossings.
+     */
+    uint16_t getTimeout() const {
+        return m_params.timeout;
+    }
+
+private:
+    ZeroCrossingState load(std::size_t channel) const {
+        ZeroCrossingState state;
+        state.accumulator = m_accumulator[channel];
+        state.side = static_cast<int8_t>(m_side[channel]);
+        state.primed = m_primed;
+        state.crossingCounter = static_cast<uint8_t>(m_crossingCounter[channel]);
+        state.samplesSinceCrossing = static_cast<uint16_t>(m_samplesSinceCrossing[channel]);
+        return state;
+    }
+
+    void store(std::size_t channel, const ZeroCrossingState& state) {
+        m_accumulator[channel] = state.accumulator;
+        m_side[channel] = state.side;
+        m_crossingCounter[channel] = state.crossingCounter;
+        m_samplesSinceCrossing[channel] = state.samplesSinceCrossing;
+    }
+
+#if defined(__AVX2__)
+    // Four channels per iteration; returns the first channel left for the scalar tail.
+    std::size_t updateAvx2(const int64_t* positions, uint8_t* events) {
+        const __m128i shift = _mm_cvtsi32_si128(m_params.baselineShift);
+        const __m256i ones = _mm256_set1_epi64x(-1);
+        const __m256i signFill = _mm256_sll_epi64(ones, _mm_cvtsi32_si128(64 - m_params.baselineShift));
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i one = _mm256_set1_epi64x(1);
+        const __m256i hysteresis = _mm256_set1_epi64x(m_params.hysteresis);
+        const __m256i negativeHysteresis = _mm256_set1_epi64x(-m_params.hysteresis);
+        const __m256i counterLimit = _mm256_set1_epi64x(255);
+        const __m256i sinceLimit = _mm256_set1_epi64x(65535);
+        const __m256i timeout = _mm256_set1_epi64x(m_params.timeout);
+        const __m256i sensitivity = _mm256_set1_epi64x(m_params.sensitivity);
+
+        // Arithmetic right shift of 64-bit lanes (AVX2 only has the logical one).
+        auto shiftRight = [&](__m256i v) {
+            return _mm256_or_si256(_mm256_srl_epi64(v, shift), _mm256_and_si256(_mm256_cmpgt_epi64(zero, v), signFill));
+        };
+        auto minimum = [](__m256i v, __m256i limit) {
+            return _mm256_blendv_epi8(v, limit, _mm256_cmpgt_epi64(v, limit));
+        };
+        const __m256i detectedFlag = _mm256_set1_epi64x(OscillatorEvent::Detected);
+        const __m256i extremumFlag = _mm256_set1_epi64x(OscillatorEvent::Extremum);
+        const __m256i resetFlag = _mm256_set1_epi64x(OscillatorEvent::Reset);
+        const __m256i gather = _mm256_setr_epi8(0, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                0, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+
+        std::size_t channel = 0;
+        for (; channel + 4 <= m_channels; channel += 4) {
+            const __m256i position = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(positions + channel));
+            __m256i accumulator = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_accumulator.data() + channel));
+            accumulator = _mm256_sub_epi64(_mm256_add_epi64(accumulator, position), shiftRight(accumulator));
+            const __m256i deviation = _mm256_sub_epi64(position, shiftRight(accumulator));
+
+            const __m256i above = _mm256_cmpgt_epi64(deviation, hysteresis);
+            const __m256i below = _mm256_cmpgt_epi64(negativeHysteresis, deviation);
+            const __m256i previousSide = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_side.data() + channel));
+            const __m256i side = _mm256_or_si256(
+                _mm256_andnot_si256(_mm256_or_si256(above, below), previousSide),
+                _mm256_or_si256(_mm256_and_si256(above, one), below));
+            const __m256i crossed = _mm256_andnot_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi64(previousSide, zero), _mm256_cmpeq_epi64(side, previousSide)), ones);
+
+            __m256i counter = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_crossingCounter.data() + channel));
+            counter = minimum(_mm256_sub_epi64(counter, crossed), counterLimit);
+            __m256i since = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_samplesSinceCrossing.data() + channel));
+            since = _mm256_andnot_si256(crossed, minimum(_mm256_add_epi64(since, one), sinceLimit));
+            const __m256i timedOut = _mm256_cmpgt_epi64(since, timeout);
+            const __m256i reset = _mm256_and_si256(timedOut, _mm256_cmpgt_epi64(counter, zero));
+            counter = _mm256_andnot_si256(timedOut, counter);
+            const __m256i detected = _mm256_cmpgt_epi64(counter, sensitivity);
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(m_accumulator.data() + channel), accumulator);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(m_side.data() + channel), side);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(m_crossingCounter.data() + channel), counter);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(m_samplesSinceCrossing.data() + channel), since);
+
+            if (events) {
+                // Flags in the low byte of each lane, then bytes 0 and 8 of both halves into 4 bytes.
+                const __m256i flags = _mm256_or_si256(_mm256_and_si256(detected, detectedFlag),
+                    _mm256_or_si256(_mm256_and_si256(crossed, extremumFlag), _mm256_and_si256(reset, resetFlag)));
+                const __m256i packed = _mm256_shuffle_epi8(flags, gather);
+                const uint32_t bytes = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm256_castsi256_si128(packed)) & 0xffff)
+                    | static_cast<uint32_t>(_mm_cvtsi128_si32(_mm256_extracti128_si256(packed, 1))) << 16;
+                std::memcpy(events + channel, &bytes, sizeof(bytes));
+            }
+        }
+        return channel;
+    }
+#endif
+
+    std::size_t m_channels;
+    ZeroCrossingParams m_params;
+    std::vector<int64_t> m_accumulator;
+    std::vector<int64_t> m_side;
+    std::vector<int64_t> m_crossingCounter;
+    std::vector<int64_t> m_samplesSinceCrossing;
+    bool m_primed = false; // all channels receive their first sample together
+    mutable std::vector<uint16_t> m_scores;
+};
@@ -1,9 +1,24 @@
 ﻿#include "pch.h"
 #include "OscillatorDetector.hpp"
+#include "OscillatorPipeline.hpp"
+#include "OscillatorDetectorBank.hpp"
+#include "OscillatorCorrelation.hpp"
+#include "SpectralOscillatorDetector.hpp"
+#include "ZeroCrossingOscillatorDetector.hpp"
+#include "OscillatorReorderBuffer.hpp"
+#include "OscillatorHistory.hpp"
+#include "PlanarOscillatorDetector.hpp"
+#include "OscillatorReplay.hpp"
+#include "OscillatorFlightRecorder.hpp"
 
 
 #include <cmath>
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <sstream>
+#include <vector>
 
 #define DEG2RAD(x) ((x) * 3.14159265358979323846 / 180.0)
 
@@ -358,4 +373,1708 @@ TEST(OscillatorDetectorTest, DecreasingVerySmallAmplitude) {
     }
 
     EXPECT_FALSE(detected);
-}
\ No newline at end of file
+}
+
+static PipelineTask sinSource(SampleChannel& channel, uint32_t stream, int batches, int batchSize) {
+    int64_t prev = 0;
+    for (int b = 0; b < batches; ++b) {
+        SampleBatch batch;
+        batch.stream = stream;
+        batch.firstSample = static_cast<uint64_t>(b) * batchSize;
+        for (int k = 0; k < batchSize; ++k) {
+            int i = b * batchSize + k;
+            int64_t position = static_cast<int64_t>(1000.0 * std::sin(DEG2RAD(i * (1 + stream % 3))));
+            batch.positions.push_back(position);
+            batch.directions.push_back(static_cast<int8_t>(std::clamp(position - prev, int64_t{ -1 }, int64_t{ 1 })));
+            prev = position;
+        }
+        co_await channel.push(std::move(batch));
+    }
+    channel.close();
+}
+
+static PipelineTask countingSink(EventChannel& channel, std::vector<std::atomic<int>>& counts) {
+    while (auto events = co_await channel.pop()) {
+        for (const DetectionEvent& event : *events) {
+            counts[event.stream].fetch_add(1);
+        }
+    }
+}
+
+TEST(OscillatorPipelineTest, StreamsMatchSynchronousDetection) {
+    const uint32_t streams = 256;
+    const int batches = 20;
+    const int batchSize = 90;
+
+    PipelineExecutor executor(3);
+    EventChannel events(executor, 16, streams);
+    std::vector<std::unique_ptr<SampleChannel>> inputs;
+    std::vector<OscillatorDetector> detectors(streams);
+    std::vector<std::atomic<int>> counts(streams);
+    std::vector<PipelineTask> producers;
+    std::vector<PipelineTask> stages;
+
+    for (uint32_t s = 0; s < streams; ++s) {
+        inputs.push_back(std::make_unique<SampleChannel>(executor, 2));
+        stages.push_back(detectorStage(*inputs[s], events, detectors[s]));
+        producers.push_back(sinSource(*inputs[s], s, batches, batchSize));
+    }
+    PipelineTask sink = countingSink(events, counts);
+
+    sink.start(executor);
+    for (auto& stage : stages) stage.start(executor);
+    for (auto& producer : producers) producer.start(executor);
+
+    for (auto& producer : producers) producer.join();
+    // The last stage to end closes the event channel, which ends the sink.
+    sink.join();
+    for (auto& stage : stages) stage.join();
+
+    for (uint32_t s = 0; s < streams; ++s) {
+        OscillatorDetector reference;
+        int expected = 0;
+        int64_t prev = 0;
+        for (int i = 0; i < batches * batchSize; ++i) {
+            int64_t position = static_cast<int64_t>(1000.0 * std::sin(DEG2RAD(i * (1 + s % 3))));
+            int direction = static_cast<int>(std::clamp(position - prev, int64_t{ -1 }, int64_t{ 1 }));
+            expected += reference.detect(position, direction) ? 1 : 0;
+            prev = position;
+        }
+        EXPECT_GT(expected, 0);
+        EXPECT_EQ(counts[s].load(), expected) << "stream " << s;
+    }
+}
+
+TEST(OscillatorPipelineTest, StageClosesItsOutput) {
+    PipelineExecutor executor(2);
+    SampleChannel samples(executor, 2);
+    EventChannel events(executor, 4);
+    std::vector<std::atomic<int>> counts(1);
+    OscillatorDetector detector;
+
+    PipelineTask stage = detectorStage(samples, events, detector);
+    PipelineTask producer = sinSource(samples, 0, 40, 90);
+    PipelineTask sink = countingSink(events, counts);
+    EXPECT_DEBUG_DEATH(sink.join(), "never started");
+
+    sink.start(executor);
+    stage.start(executor);
+    producer.start(executor);
+    // Nobody closes `events` here: the stage does once `samples` is drained.
+    sink.join();
+    EXPECT_TRUE(stage.isDone());
+    EXPECT_GT(counts[0].load(), 0);
+    producer.join();
+}
+
+TEST(OscillatorDetectorTest, HoldOffLimitsEventRate) {
+    OscillatorDetector free;
+    OscillatorDetector held;
+    held.setHoldOff(360);
+
+    const int samples = 7200;
+    const double amplitude = 1000.0;
+
+    int64_t prev = 0;
+    int freeEvents = 0;
+    int heldEvents = 0;
+    int lastHeldEvent = -1000;
+    int minGap = samples;
+
+    for (int i = 0; i <= samples; ++i) {
+        double value = amplitude * std::sin(DEG2RAD(i));
+        int64_t position = static_cast<int64_t>(value);
+        int direction = static_cast<int>(std::clamp(position - prev, int64_t{ -1 }, int64_t{ 1 }));
+        freeEvents += free.detect(position, direction) ? 1 : 0;
+        if (held.detect(position, direction)) {
+            ++heldEvents;
+            minGap = std::min(minGap, i - lastHeldEvent);
+            lastHeldEvent = i;
+        }
+        prev = position;
+    }
+
+    EXPECT_GT(heldEvents, 1);
+    EXPECT_GT(minGap, 360);
+    EXPECT_LE(heldEvents, samples / 361 + 1);
+    EXPECT_GT(freeEvents, 10 * heldEvents);
+}
+
+template <typename Policy>
+class OscillatorResetPolicyTest : public ::testing::Test {};
+
+using RearmPolicies = ::testing::Types<OscillatorReset::Decrement, OscillatorReset::Sliding, OscillatorReset::KeepLastExtremum>;
+TYPED_TEST_SUITE(OscillatorResetPolicyTest, RearmPolicies);
+
+TYPED_TEST(OscillatorResetPolicyTest, NoisySinRecoversFromResets) {
+    BasicOscillatorDetector<TypeParam> detector;
+    OscillatorDetector fullReset;
+    const int samples = 7200;
+    const double amplitude = 1000.0;
+
+    int64_t prev = 0;
+    uint32_t seed = 1;
+    bool detected = false;
+    bool fullResetDetected = false;
+
+    for (int i = 0; i <= samples; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        double value = amplitude * std::sin(DEG2RAD(i)) + static_cast<double>((seed >> 16) % 40);
+        int64_t position = static_cast<int64_t>(value);
+        int direction = static_cast<int>(std::clamp(position - prev, int64_t{ -1 }, int64_t{ 1 }));
+        detected |= detector.detect(position, direction);
+        fullResetDetected |= fullReset.detect(position, direction);
+        prev = position;
+    }
+
+    EXPECT_FALSE(fullResetDetected);
+    EXPECT_TRUE(detected);
+}
+
+TYPED_TEST(OscillatorResetPolicyTest, DecreasingSinSlow) {
+    BasicOscillatorDetector<TypeParam> detector;
+    const int samples = 7200;
+    double amplitude = 1000.0;
+
+    int64_t prev = 0;
+    bool detected = false;
+
+    for (int i = 0; i <= samples; ++i) {
+        amplitude -= 0.5;
+        amplitude = std::clamp(amplitude, 0.1, 1000.0);
+        double value = amplitude * std::sin(DEG2RAD(i));
+        int64_t position = static_cast<int64_t>(value);
+        int direction = static_cast<int>(std::clamp(position - prev, int64_t{ -1 }, int64_t{ 1 }));
+        detected |= detector.detect(position, direction);
+        prev = position;
+    }
+
+    EXPECT_FALSE(detected);
+}
+
+TEST(OscillatorDetectorBankTest, ChannelsMatchStandaloneDetectors) {
+    const std::size_t channels = 37; // not a multiple of the block width
+    const int samples = 3600;
+
+    OscillatorDetectorBank bank(channels);
+    bank.setSensitivity(3);
+    bank.setHoldOff(50);
+    std::vector<OscillatorDetector> detectors(channels);
+    for (auto& detector : detectors) {
+        detector.setSensitivity(3);
+        detector.setHoldOff(50);
+    }
+
+    std::vector<int64_t> positions(channels);
+    std::vector<int8_t> directions(channels);
+    std::vector<int64_t> prev(channels, 0);
+    std::vector<uint8_t> events(channels);
+    uint32_t seed = 7;
+
+    for (int i = 0; i <= samples; ++i) {
+        for (std::size_t c = 0; c < channels; ++c) {
+            seed = seed * 1664525u + 1013904223u;
+            double amplitude = 100.0 + 20.0 * c + (c % 3 == 0 ? i * 0.5 : 0.0);
+            double value = amplitude * std::sin(DEG2RAD(i * (1 + c % 4))) + static_cast<double>((seed >> 16) % (1 + c % 5));
+            positions[c] = static_cast<int64_t>(value);
+            directions[c] = static_cast<int8_t>(std::clamp(positions[c] - prev[c], int64_t{ -1 }, int64_t{ 1 }));
+            prev[c] = positions[c];
+        }
+        bank.update(positions.data(), directions.data(), events.data());
+        for (std::size_t c = 0; c < channels; ++c) {
+            ASSERT_EQ(events[c], detectors[c].update(positions[c], directions[c])) << "channel " << c << " sample " << i;
+        }
+    }
+
+    for (std::size_t c = 0; c < channels; ++c) {
+        OscillatorDetectorState state = bank.getState(c);
+        EXPECT_EQ(state.extremaCounter, detectors[c].getState().extremaCounter);
+        EXPECT_EQ(state.maxFoundPos, detectors[c].getState().maxFoundPos);
+        EXPECT_EQ(state.minFoundPos, detectors[c].getState().minFoundPos);
+        EXPECT_EQ(bank.getScore(c), detectors[c].getScore());
+    }
+    std::vector<uint16_t> scores(channels);
+    bank.computeScores(scores.data());
+    for (std::size_t c = 0; c < channels; ++c) {
+        EXPECT_EQ(scores[c], detectors[c].getScore()) << "channel " << c;
+    }
+}
+
+TEST(OscillatorDetectorTest, ScoreRanksGrowingAboveSteadyAboveNone) {
+    OscillatorDetector growing;
+    OscillatorDetector steady;
+    OscillatorDetector linear;
+    const int samples = 3600;
+    double amplitude = 1000.0;
+
+    int64_t prevGrowing = 0;
+    int64_t prevSteady = 0;
+    int64_t prevLinear = 0;
+
+    for (int i = 0; i <= samples; ++i) {
+        amplitude += 1.0;
+        int64_t position = static_cast<int64_t>(amplitude * std::sin(DEG2RAD(i)));
+        growing.detect(position, static_cast<int>(std::clamp(position - prevGrowing, int64_t{ -1 }, int64_t{ 1 })));
+        prevGrowing = position;
+
+        position = static_cast<int64_t>(1000.0 * std::sin(DEG2RAD(i)));
+        steady.detect(position, static_cast<int>(std::clamp(position - prevSteady, int64_t{ -1 }, int64_t{ 1 })));
+        prevSteady = position;
+
+        position = i;
+        linear.detect(position, static_cast<int>(std::clamp(position - prevLinear, int64_t{ -1 }, int64_t{ 1 })));
+        prevLinear = position;
+    }
+
+    EXPECT_GT(growing.getScore(), steady.getScore());
+    EXPECT_GT(steady.getScore(), linear.getScore());
+    EXPECT_GT(steady.getScore(), 40000);
+    EXPECT_EQ(linear.getScore(), 0);
+}
+
+TEST(OscillatorDetectorBankTest, SelectTopKMatchesFullSort) {
+    const std::size_t count = 1003;
+    std::vector<uint16_t> scores(count);
+    uint32_t seed = 11;
+    for (auto& score : scores) {
+        seed = seed * 1664525u + 1013904223u;
+        score = static_cast<uint16_t>((seed >> 8) % 5000 + ((seed >> 20) % 4 == 0 ? 60000 : 0));
+    }
+
+    std::vector<uint32_t> expected(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        expected[i] = static_cast<uint32_t>(i);
+    }
+    std::sort(expected.begin(), expected.end(), [&](uint32_t a, uint32_t b) {
+        return scores[a] != scores[b] ? scores[a] > scores[b] : a < b;
+    });
+
+    for (std::size_t k : { std::size_t{ 1 }, std::size_t{ 10 }, std::size_t{ 300 }, count + 5 }) {
+        std::vector<uint32_t> top(k);
+        std::size_t written = OscillatorDetectorBank::selectTopK(scores.data(), count, k, top.data());
+        ASSERT_EQ(written, std::min(k, count));
+        for (std::size_t i = 0; i < written; ++i) {
+            EXPECT_EQ(top[i], expected[i]) << "k " << k << " rank " << i;
+        }
+    }
+}
+
+TEST(OscillatorDetectorTest, EnvelopeClassification) {
+    OscillatorDetector growing;
+    OscillatorDetector steady;
+    OscillatorDetector decaying;
+    const int samples = 7200;
+    double amplitude = 1000.0;
+
+    int64_t prevGrowing = 0;
+    int64_t prevSteady = 0;
+    int64_t prevDecaying = 0;
+
+    EXPECT_EQ(steady.getEnvelope(), OscillatorEnvelope::Unknown);
+
+    for (int i = 0; i <= samples; ++i) {
+        amplitude += 10 * i;
+        int64_t position = static_cast<int64_t>(amplitude * std::sin(DEG2RAD(i)));
+        growing.detect(position, static_cast<int>(std::clamp(position - prevGrowing, int64_t{ -1 }, int64_t{ 1 })));
+        prevGrowing = position;
+
+        position = static_cast<int64_t>(1000.0 * std::sin(DEG2RAD(i)));
+        steady.detect(position, static_cast<int>(std::clamp(position - prevSteady, int64_t{ -1 }, int64_t{ 1 })));
+        prevSteady = position;
+
+        position = static_cast<int64_t>(std::clamp(2000.0 - 0.25 * i, 0.1, 2000.0) * std::sin(DEG2RAD(i * 2)));
+        decaying.detect(position, static_cast<int>(std::clamp(position - prevDecaying, int64_t{ -1 }, int64_t{ 1 })));
+        prevDecaying = position;
+    }
+
+    EXPECT_EQ(growing.getEnvelope(), OscillatorEnvelope::Growing);
+    EXPECT_EQ(steady.getEnvelope(), OscillatorEnvelope::Steady);
+    EXPECT_EQ(decaying.getEnvelope(), OscillatorEnvelope::Decaying);
+    EXPECT_GT(growing.getGrowthRate(), 1.0f);
+    EXPECT_LT(decaying.getGrowthRate(), 1.0f);
+}
+
+TEST(OscillatorDetectorTest, GrowthRateOfExponentialEnvelope) {
+    for (double rate : { 0.9, 1.1 }) {
+        OscillatorDetector detector;
+        const int samples = 3600;
+        int64_t prev = 0;
+
+        for (int i = 0; i <= samples; ++i) {
+            double amplitude = (rate < 1.0 ? 100000.0 : 100.0) * std::pow(rate, i / 180.0); // rate per half period
+            int64_t position = static_cast<int64_t>(amplitude * std::sin(DEG2RAD(i)));
+            detector.detect(position, static_cast<int>(std::clamp(position - prev, int64_t{ -1 }, int64_t{ 1 })));
+            prev = position;
+        }
+
+        EXPECT_NEAR(detector.getGrowthRate(), rate, 0.01);
+        EXPECT_EQ(detector.getEnvelope(), rate < 1.0 ? OscillatorEnvelope::Decaying : OscillatorEnvelope::Growing);
+    }
+}
+
+TEST(OscillatorDetectorTest, ModalEstimatesOfDampedSine) {
+    const double pi = 3.14159265358979;
+    for (double zeta : { 0.01, 0.05 }) {
+        OscillatorDetector detector;
+        const double period = 360.0;
+        const double damped = 2.0 * pi / period;
+        const double natural = damped / std::sqrt(1.0 - zeta * zeta);
+        int64_t prev = 0;
+
+        for (int i = 0; i <= 7200; ++i) {
+            double amplitude = 1000000.0 * std::exp(-zeta * natural * i);
+            if (amplitude < 2000.0) {
+                break;
+            }
+            int64_t position = static_cast<int64_t>(amplitude * std::sin(damped * i));
+            detector.detect(position, static_cast<int>(std::clamp(position - prev, int64_t{ -1 }, int64_t{ 1 })));
+            prev = position;
+        }
+
+        EXPECT_NEAR(detector.getDampingRatio(), zeta, 0.002);
+        EXPECT_NEAR(detector.getNaturalFrequency(1000.0f), 1000.0 * natural / (2.0 * pi), 0.01 * 1000.0 * natural / (2.0 * pi));
+    }
+}
+
+TEST(OscillatorDetectorBankTest, ModalEstimatesMatchDetectors) {
+    const std::size_t channels = 21;
+    OscillatorDetectorBank bank(channels);
+    std::vector<OscillatorDetector> detectors(channels);
+    std::vector<int64_t> positions(channels);
+    std::vector<int8_t> directions(channels);
+    std::vector<int64_t> prev(channels, 0);
+
+    for (int i = 0; i <= 3600; ++i) {
+        for (std::size_t c = 0; c < channels; ++c) {
+            double amplitude = 100000.0 * std::pow(0.8 + 0.02 * c, i / 180.0);
+            positions[c] = static_cast<int64_t>(amplitude * std::sin(DEG2RAD(i * (1 + c % 3))));
+            directions[c] = static_cast<int8_t>(std::clamp(positions[c] - prev[c], int64_t{ -1 }, int64_t{ 1 }));
+            prev[c] = positions[c];
+            detectors[c].update(positions[c], directions[c]);
+        }
+        bank.update(positions.data(), directions.data(), nullptr);
+    }
+
+    std::vector<float> damping(channels);
+    std::vector<float> frequency(channels);
+    bank.computeModalEstimates(damping.data(), frequency.data(), 100.0f);
+    for (std::size_t c = 0; c < channels; ++c) {
+        EXPECT_FLOAT_EQ(damping[c], detectors[c].getDampingRatio());
+        EXPECT_FLOAT_EQ(frequency[c], detectors[c].getNaturalFrequency(100.0f));
+    }
+}
+
+TEST(OscillatorCorrelationTest, FindsCouplingClusters) {
+    const std::size_t channels = 13;
+    OscillatorCorrelation correlation(channels, 128, 4);
+    std::vector<uint8_t> events(channels);
+    uint32_t seed = 11;
+
+    for (int i = 0; i < 1000; ++i) {
+        for (std::size_t c = 0; c < channels; ++c) {
+            seed = seed * 1664525u + 1013904223u;
+            bool extremum = false;
+            if (c < 5) {
+                extremum = (i - static_cast<int>(c % 2)) % 20 == 0;  // group A, small phase lag
+            }
+            else if (c < 10) {
+                extremum = i % 33 == 0;                              // group B
+            }
+            else if (c == 12) {
+                extremum = (seed >> 16) % 25 == 0;                   // uncorrelated
+            }
+            events[c] = extremum ? OscillatorEvent::Extremum : 0;
+        }
+        correlation.record(events.data());
+    }
+
+    EXPECT_FLOAT_EQ(correlation.similarity(0, 1), 1.0f);
+    EXPECT_LT(correlation.similarity(0, 5), 0.5f);
+    EXPECT_EQ(correlation.activity(10), 0u);
+
+    std::vector<uint32_t> labels(channels);
+    EXPECT_EQ(correlation.findClusters(0.5f, labels.data()), 2u);
+    for (std::size_t c = 0; c < channels; ++c) {
+        EXPECT_EQ(labels[c], c < 5 ? 0u : c < 10 ? 5u : c) << "channel " << c;
+    }
+}
+
+TEST(OscillatorCorrelationTest, WindowForgetsOldExtrema) {
+    OscillatorCorrelation correlation(2, 64, 2);
+    uint8_t events[2] = { OscillatorEvent::Extremum, OscillatorEvent::Extremum };
+    correlation.record(events);
+    EXPECT_EQ(correlation.activity(0), 1u);
+
+    events[0] = events[1] = 0;
+    for (int i = 0; i < 127; ++i) {
+        correlation.record(events);
+    }
+    EXPECT_EQ(correlation.activity(0), 1u); // 128 samples: still inside 64 bins of 2 samples
+    correlation.record(events);
+    EXPECT_EQ(correlation.activity(0), 0u);
+    EXPECT_FLOAT_EQ(correlation.similarity(0, 1), 0.0f);
+
+    // Every word count up to 19 covers the vector loop with each possible scalar tail.
+    uint64_t a[19]{};
+    uint64_t b[19]{};
+    uint32_t expected = 0;
+    EXPECT_EQ(OscillatorCorrelation::popcountAnd(a, b, 0), 0u);
+    for (int w = 0; w < 19; ++w) {
+        a[w] = 0x9e3779b97f4a7c15ull * (w + 1);
+        b[w] = w == 5 ? ~uint64_t{ 0 } : 0xc2b2ae3d27d4eb4full * (w + 3);
+        expected += static_cast<uint32_t>(std::popcount(a[w] & b[w]));
+        EXPECT_EQ(OscillatorCorrelation::popcountAnd(a, b, w + 1), expected) << (w + 1) << " words";
+    }
+}
+
+TEST(SpectralOscillatorDetectorTest, FindsToneInNoise) {
+    for (double amplitude : { 0.0, 1000.0 }) {
+        SpectralOscillatorDetector detector({ 1.0f / 90.0f, 1.0f / 64.0f, 1.0f / 30.0f }, 256);
+        uint32_t seed = 5;
+        int detections = 0;
+
+        for (int i = 0; i < 4000; ++i) {
+            double noise = 0.0;
+            for (int j = 0; j < 4; ++j) {
+                seed = seed * 1664525u + 1013904223u;
+                noise += static_cast<double>(seed >> 16) / 65536.0 - 0.5; // sum of uniforms, sigma ~0.58
+            }
+            double value = 5000.0 + amplitude * std::sin(2.0 * 3.14159265358979 * i / 64.0) + 1700.0 * noise;
+            detections += detector.detect(static_cast<int64_t>(value), 0);
+        }
+
+        if (amplitude > 0.0) {
+            EXPECT_GT(detections, 3000);
+            EXPECT_EQ(detector.getDominantFrequency(), 1u);
+        }
+        else {
+            EXPECT_EQ(detections, 0);
+            EXPECT_LT(detector.getScore(), 65535 / 20);
+        }
+    }
+}
+
+TEST(SpectralOscillatorDetectorTest, KeepsPrecisionFarFromZero) {
+    // A float has 17-bit steps at 2^40, so the tone would vanish if the positions were converted directly.
+    const int64_t offset = int64_t{ 1 } << 40;
+    SpectralOscillatorDetector nearZero;
+    SpectralOscillatorDetector farAway;
+    int nearDetections = 0;
+    int farDetections = 0;
+    for (int i = 0; i < 2000; ++i) {
+        const int64_t value = static_cast<int64_t>(1000.0 * std::sin(2.0 * 3.14159265358979 * i / 64.0));
+        nearDetections += nearZero.detect(value, 0);
+        farDetections += farAway.detect(offset + value, 0);
+        ASSERT_EQ(farAway.getScore(), nearZero.getScore()) << "sample " << i;
+    }
+    EXPECT_GT(nearDetections, 1000);
+    EXPECT_EQ(farDetections, nearDetections);
+}
+
+TEST(SpectralOscillatorDetectorBankTest, ChannelsMatchStandaloneDetectors) {
+    const std::size_t channels = 19;
+    const std::vector<float> frequencies = { 0.01f, 0.02f, 0.05f, 0.1f };
+    SpectralOscillatorDetectorBank bank(channels, frequencies, 128);
+    std::vector<SpectralOscillatorDetector> detectors(channels, SpectralOscillatorDetector(frequencies, 128));
+    std::vector<int64_t> positions(channels);
+    std::vector<uint8_t> events(channels);
+    uint32_t seed = 9;
+
+    for (int i = 0; i < 2000; ++i) {
+        for (std::size_t c = 0; c < channels; ++c) {
+            seed = seed * 1664525u + 1013904223u;
+            double value = 300.0 * std::sin(2.0 * 3.14159265358979 * frequencies[c % 4] * i) * (c % 3) + static_cast<double>((seed >> 16) % 400);
+            positions[c] = static_cast<int64_t>(value);
+        }
+        bank.update(positions.data(), nullptr, events.data());
+        for (std::size_t c = 0; c < channels; ++c) {
+            uint8_t expected = detectors[c].update(positions[c], 0);
+            ASSERT_NEAR(bank.getScore(c), detectors[c].getScore(), 2) << "channel " << c << " sample " << i;
+            if (std::abs(detectors[c].getScore() - 65535 * 0.2) > 4) {
+                ASSERT_EQ(events[c], expected) << "channel " << c << " sample " << i;
+            }
+        }
+    }
+
+    uint32_t top[3];
+    ASSERT_EQ(bank.topK(3, top), 3u);
+    EXPECT_NE(top[0] % 3, 0u); // channels with c % 3 == 0 carry only noise
+}
+
+TEST(ZeroCrossingOscillatorDetectorTest, OscillationAroundDriftingSetpoint) {
+    for (double amplitude : { 0.0, 100.0 }) {
+        ZeroCrossingOscillatorDetector detector;
+        detector.setHysteresis(30);
+        uint32_t seed = 3;
+        int detections = 0;
+        int crossings = 0;
+
+        for (int i = 0; i < 2000; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            double setpoint = 1000.0 + 0.5 * i;
+            double value = setpoint + amplitude * std::sin(DEG2RAD(i * 9)) + static_cast<double>((seed >> 16) % 41) - 20.0;
+            uint8_t flags = detector.update(static_cast<int64_t>(value), 0);
+            detections += (flags & OscillatorEvent::Detected) != 0;
+            crossings += (flags & OscillatorEvent::Extremum) != 0;
+        }
+
+        if (amplitude > 0.0) {
+            EXPECT_NEAR(crossings, 100, 2); // two per 40-sample period
+            EXPECT_GT(detections, 1800);
+        }
+        else {
+            EXPECT_EQ(detections, 0);
+            EXPECT_NEAR(static_cast<double>(detector.getBaseline()), 1000.0 + 0.5 * 2000 - 32.0, 20.0); // EMA lags by slope * 64
+        }
+    }
+}
+
+TEST(ZeroCrossingOscillatorDetectorBankTest, ChannelsMatchStandaloneDetectors) {
+    const std::size_t channels = 23; // vector groups of 4 plus a scalar tail
+    ZeroCrossingOscillatorDetectorBank bank(channels);
+    bank.setHysteresis(15);
+    bank.setTimeout(60);
+    std::vector<ZeroCrossingOscillatorDetector> detectors(channels);
+    for (auto& detector : detectors) {
+        detector.setHysteresis(15);
+        detector.setTimeout(60);
+    }
+
+    std::vector<int64_t> positions(channels);
+    std::vector<uint8_t> events(channels);
+    uint32_t seed = 17;
+
+    for (int i = 0; i < 3000; ++i) {
+        for (std::size_t c = 0; c < channels; ++c) {
+            seed = seed * 1664525u + 1013904223u;
+            double amplitude = (i / 500 + c) % 3 == 0 ? 0.0 : 40.0 * (c % 4);
+            double value = -5000.0 * static_cast<double>(c) + amplitude * std::sin(DEG2RAD(i * (3 + c % 5))) + static_cast<double>((seed >> 16) % 25);
+            positions[c] = static_cast<int64_t>(value);
+        }
+        bank.update(positions.data(), nullptr, events.data());
+        for (std::size_t c = 0; c < channels; ++c) {
+            ASSERT_EQ(events[c], detectors[c].update(positions[c], 0)) << "channel " << c << " sample " << i;
+        }
+    }
+
+    for (std::size_t c = 0; c < channels; ++c) {
+        EXPECT_EQ(bank.getState(c).accumulator, detectors[c].getState().accumulator);
+        EXPECT_EQ(bank.getScore(c), detectors[c].getScore());
+    }
+}
+
+TEST(OscillatorDetectorTest, AdaptiveSmoothingStopsResetChurn) {
+    const std::size_t channels = 2; // fixed and adaptive threshold
+    OscillatorDetectorBank bank(channels);
+    bank.setNoiseGain(16);
+    OscillatorDetector fixed;
+    OscillatorDetector adaptive;
+    adaptive.setNoiseGain(16);
+
+    int64_t prev = 0;
+    int fixedResets = 0;
+    int adaptiveResets = 0;
+    int firstDetection = -1;
+    uint32_t seed = 1;
+
+    for (int i = 0; i < 3600; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        double noise = static_cast<double>((seed >> 16) % 41) - 20.0;
+        int64_t position = static_cast<int64_t>(1000.0 * std::sin(DEG2RAD(i)) + noise);
+        int direction = static_cast<int>(std::clamp(position - prev, int64_t{ -1 }, int64_t{ 1 }));
+        prev = position;
+
+        fixedResets += (fixed.update(position, direction) & OscillatorEvent::Reset) != 0;
+        uint8_t flags = adaptive.update(position, direction);
+        adaptiveResets += (flags & OscillatorEvent::Reset) != 0;
+        if ((flags & OscillatorEvent::Detected) && firstDetection < 0) {
+            firstDetection = i;
+        }
+
+        const int64_t positions[channels] = { position, position };
+        const int8_t directions[channels] = { static_cast<int8_t>(direction), static_cast<int8_t>(direction) };
+        uint8_t events[channels];
+        bank.update(positions, directions, events);
+        ASSERT_EQ(events[0], flags) << "sample " << i;
+    }
+
+    EXPECT_GT(fixedResets, 10);
+    EXPECT_EQ(adaptiveResets, 0);
+    EXPECT_GT(firstDetection, 0);
+    EXPECT_LT(firstDetection, 1100); // about as early as on a clean signal
+    EXPECT_GT(adaptive.getEffectiveSmootherThreshold(), fixed.getEffectiveSmootherThreshold());
+}
+
+TEST(OscillatorDetectorTest, TransitionTableMatchesPredicates) {
+    OscillatorDetectorParams params;
+    params.smootherThreshold = 2;
+    uint32_t seed = 21;
+
+    for (int i = 0; i < 100000; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        OscillatorDetectorState state;
+        state.lastDirection = static_cast<int>(seed % 3) - 1;
+        state.maxFoundPos = (seed >> 4) % 8;
+        state.minFoundPos = (seed >> 7) % 8;
+        state.maximumDebounceCounter = static_cast<uint8_t>((seed >> 10) % 5);
+        state.minimumDebounceCounter = static_cast<uint8_t>((seed >> 13) % 5);
+        const int64_t position = (seed >> 16) % 8;
+        const int direction = static_cast<int>((seed >> 19) % 3) - 1;
+
+        ASSERT_EQ(OscillatorDetector::classifyTable(params, state, position, direction),
+                  OscillatorDetector::classify(params, state, position, direction)) << "iteration " << i;
+    }
+}
+
+TEST(OscillatorDetectorTest, TimestampedMatchesCountsOnCleanSignal) {
+    // Without plateau noise every extremum is reached once, so neither debounce
+    // arms the reset path and both forms count the same extrema.
+    OscillatorDetector counted;
+    OscillatorDetector timed;
+    timed.setSmootherTime(5 * 1000000); // smootherThreshold 5 at 1 ms per sample
+
+    int64_t prev = 0;
+    int detections = 0;
+    for (int i = 0; i < 3600; ++i) {
+        int64_t position = static_cast<int64_t>(1000.0 * std::sin(DEG2RAD(i * 3)));
+        int direction = static_cast<int>(std::clamp(position - prev, int64_t{ -1 }, int64_t{ 1 }));
+        prev = position;
+        const uint8_t events = timed.update(position, direction, int64_t{ i } * 1000000);
+        ASSERT_EQ(events, counted.update(position, direction)) << "sample " << i;
+        detections += (events & OscillatorEvent::Detected) != 0;
+    }
+    EXPECT_GT(detections, 0);
+}
+
+TEST(OscillatorDetectorTest, DebounceDwellIsElapsedTime) {
+    // Two updates reach the maximum; the time between them is the dwell, however
+    // many samples lie in between. A lower maximum afterwards resets once the
+    // dwell exceeds smootherTime.
+    for (int64_t gap : { int64_t{ 1 }, int64_t{ 3 }, int64_t{ 9 } }) {
+        OscillatorDetector detector;
+        detector.setSmootherTime(5 * 1000000);
+        int64_t now = 0;
+        auto update = [&](int64_t position, int direction, int64_t step) {
+            now += step * 1000000;
+            return detector.update(position, direction, now);
+        };
+        for (int i = 1; i <= 10; ++i) {
+            update(i * 10, 1, 1);
+        }
+        update(100, 0, 1);  // reaches the maximum and starts the debounce
+        update(100, 0, 1);
+        update(100, 0, gap); // irregular spacing: one long interval or none
+        update(101, 1, 1);
+        update(101, 0, 1);  // reaches it again, 3 + gap ms after the start
+        update(100, 1, 1);
+        const uint8_t events = update(99, -1, 1); // lower maximum
+        EXPECT_EQ((events & OscillatorEvent::Reset) != 0, 3 + gap > 5) << "gap " << gap << " ms";
+    }
+}
+
+TEST(OscillatorDetectorTest, FirstTimestampedSampleAtAnyTime) {
+    // The first sample must not compute a gap against the "no sample yet"
+    // marker; this test is meant to be run under -fsanitize=undefined as well.
+    const int64_t starts[] = { 0, std::numeric_limits<int64_t>::max(), -1, std::numeric_limits<int64_t>::min() + 1 };
+    for (int64_t start : starts) {
+        OscillatorDetector detector;
+        detector.setStaleAfter(1000);
+        detector.setDetectionWindow(1000);
+        EXPECT_EQ(detector.getTimingState().lastTimestamp, std::numeric_limits<int64_t>::min());
+        EXPECT_EQ(detector.update(5, 1, start) & OscillatorEvent::Reset, 0) << "start " << start;
+        EXPECT_EQ(detector.getTimingState().lastTimestamp, start);
+
+        OscillatorDetector copy = detector;
+        EXPECT_EQ(copy.getTimingState().lastTimestamp, start);
+        const int64_t later = start > 0 ? start : start + 5000;
+        EXPECT_EQ(copy.update(5, 1, later) & OscillatorEvent::Reset, start > 0 ? 0 : OscillatorEvent::Reset) << "start " << start;
+        EXPECT_EQ(detector.getTimingState().lastTimestamp, start);
+    }
+}
+
+TEST(OscillatorDetectorBankTest, TimestampedChannelsMatchStandaloneDetectors) {
+    const std::size_t channels = 21;
+    OscillatorDetectorBank bank(channels);
+    bank.setSmootherTime(3000000);
+    bank.setDetectionWindow(400000000);
+    std::vector<OscillatorDetector> detectors(channels);
+    for (auto& detector : detectors) {
+        detector.setSmootherTime(3000000);
+        detector.setDetectionWindow(400000000);
+    }
+
+    std::vector<int64_t> positions(channels);
+    std::vector<int8_t> directions(channels);
+    std::vector<int64_t> timestamps(channels, 0);
+    std::vector<int64_t> prev(channels, 0);
+    std::vector<uint8_t> events(channels);
+    uint32_t seed = 8;
+    int resets = 0;
+
+    for (int i = 0; i < 4000; ++i) {
+        for (std::size_t c = 0; c < channels; ++c) {
+            seed = seed * 1664525u + 1013904223u;
+            timestamps[c] += (seed >> 28) < 2 ? 20000 : 1000000 + (seed >> 12) % 400000; // bursts and jitter
+            double amplitude = (i / 1000 + c) % 2 == 0 ? 500.0 : 0.0;
+            positions[c] = static_cast<int64_t>(amplitude * std::sin(DEG2RAD(i * (1 + c % 3)))) + (seed >> 16) % 31;
+            directions[c] = static_cast<int8_t>(std::clamp(positions[c] - prev[c], int64_t{ -1 }, int64_t{ 1 }));
+            prev[c] = positions[c];
+        }
+        bank.update(positions.data(), directions.data(), timestamps.data(), events.data());
+        for (std::size_t c = 0; c < channels; ++c) {
+            ASSERT_EQ(events[c], detectors[c].update(positions[c], directions[c], timestamps[c])) << "channel " << c << " sample " << i;
+            resets += (events[c] & OscillatorEvent::Reset) != 0;
+        }
+    }
+    EXPECT_GT(resets, 0);
+}
+
+TEST(OscillatorDetectorTest, DetectionWindowDropsStaleCount) {
+    OscillatorDetector detector;
+    detector.setDetectionWindow(100000000); // 100 ms
+    int64_t prev = 0;
+    int64_t now = 0;
+
+    for (int i = 0; i < 1000; ++i) {
+        now += 1000000;
+        int64_t position = static_cast<int64_t>(1000.0 * std::sin(DEG2RAD(i)));
+        detector.detect(position, static_cast<int>(std::clamp(position - prev, int64_t{ -1 }, int64_t{ 1 })), now);
+        prev = position;
+    }
+    ASSERT_GT(detector.getState().extremaCounter, 0);
+
+    // The signal stops; after the window the count is dropped once.
+    int resets = 0;
+    for (int i = 0; i < 300; ++i) {
+        now += 1000000;
+        resets += (detector.update(prev, 0, now) & OscillatorEvent::Reset) != 0;
+    }
+    EXPECT_EQ(resets, 1);
+    EXPECT_EQ(detector.getState().extremaCounter, 0);
+}
+
+TEST(OscillatorDetectorBankTest, SparseReportsMatchStandaloneDetectors) {
+    const std::size_t channels = 37;
+    OscillatorDetectorBank bank(channels);
+    bank.setStaleAfter(50000000);
+    std::vector<OscillatorDetector> detectors(channels);
+    for (auto& detector : detectors) {
+        detector.setStaleAfter(50000000);
+    }
+
+    std::vector<uint32_t> reporting;
+    std::vector<int64_t> positions, timestamps;
+    std::vector<int8_t> directions;
+    std::vector<int64_t> prev(channels, 0);
+    std::vector<int64_t> lastReport(channels, 0);
+    std::vector<uint8_t> events(channels);
+    uint32_t seed = 3;
+    int64_t now = 0;
+    int restarts = 0;
+
+    for (int i = 0; i < 3000; ++i) {
+        now += 1000000;
+        reporting.clear(), positions.clear(), directions.clear(), timestamps.clear();
+        for (uint32_t c = 0; c < channels; ++c) {
+            seed = seed * 1664525u + 1013904223u;
+            bool silent = (i / 200 + c) % 4 == 0; // long gaps on a rotating quarter of the channels
+            if (silent || (seed >> 28) < 4) {
+                continue;
+            }
+            int64_t position = static_cast<int64_t>(500.0 * std::sin(DEG2RAD(i * (1 + c % 3)))) + (seed >> 16) % 31;
+            reporting.push_back(c);
+            positions.push_back(position);
+            directions.push_back(static_cast<int8_t>(std::clamp(position - prev[c], int64_t{ -1 }, int64_t{ 1 })));
+            timestamps.push_back(now);
+            prev[c] = position;
+        }
+        bank.update(reporting.data(), reporting.size(), positions.data(), directions.data(), timestamps.data(), events.data());
+        for (std::size_t r = 0; r < reporting.size(); ++r) {
+            uint32_t c = reporting[r];
+            ASSERT_EQ(events[r], detectors[c].update(positions[r], directions[r], timestamps[r])) << "channel " << c << " sample " << i;
+            ASSERT_EQ(bank.getState(c).extremaCounter, detectors[c].getState().extremaCounter);
+            if (lastReport[c] != 0 && timestamps[r] - lastReport[c] > 50000000) {
+                EXPECT_NE(events[r] & OscillatorEvent::Reset, 0);
+                ++restarts;
+            }
+            lastReport[c] = timestamps[r];
+        }
+    }
+    EXPECT_GT(restarts, 0);
+}
+
+TEST(OscillatorDetectorBankTest, ExpireResetsOnlySilentChannels) {
+    const std::size_t channels = 45;
+    OscillatorDetectorBank bank(channels);
+    bank.setStaleAfter(20000000);
+    std::vector<int64_t> positions(channels), timestamps(channels);
+    std::vector<int8_t> directions(channels);
+    int64_t now = 0;
+
+    for (int i = 0; i < 400; ++i) {
+        now += 1000000;
+        for (std::size_t c = 0; c < channels; ++c) {
+            positions[c] = static_cast<int64_t>(1000.0 * std::sin(DEG2RAD(i * 8)));
+            directions[c] = static_cast<int8_t>(std::cos(DEG2RAD(i * 8)) > 0 ? 1 : -1);
+            timestamps[c] = now;
+        }
+        bank.update(positions.data(), directions.data(), timestamps.data(), nullptr);
+    }
+    EXPECT_GT(bank.getState(channels - 1).extremaCounter, 0);
+    EXPECT_EQ(bank.expire(now), 0u);
+
+    // Only the channels divisible by 3 keep reporting.
+    std::vector<uint32_t> active;
+    for (uint32_t c = 0; c < channels; c += 3) {
+        active.push_back(c);
+    }
+    for (int i = 0; i < 30; ++i) {
+        now += 1000000;
+        std::fill(timestamps.begin(), timestamps.end(), now);
+        bank.update(active.data(), active.size(), positions.data(), directions.data(), timestamps.data(), nullptr);
+    }
+
+    EXPECT_EQ(bank.expire(now), channels - active.size());
+    EXPECT_EQ(bank.expire(now + 1000000000), active.size());
+    EXPECT_EQ(bank.expire(now + 2000000000), 0u);
+    for (std::size_t c = 0; c < channels; ++c) {
+        EXPECT_EQ(bank.getState(c).extremaCounter, 0) << "channel " << c;
+    }
+}
+
+TEST(OscillatorReorderBufferTest, RestoresOrderWithinLateness) {
+    const int samples = 5000;
+    std::vector<OscillatorSample> ordered(samples);
+    for (int i = 0; i < samples; ++i) {
+        int64_t position = static_cast<int64_t>(1000.0 * std::sin(DEG2RAD(i * 3)));
+        int64_t previous = static_cast<int64_t>(1000.0 * std::sin(DEG2RAD((i - 1) * 3)));
+        ordered[i] = { i * int64_t{ 1000000 }, position, static_cast<int8_t>(std::clamp(position - previous, int64_t{ -1 }, int64_t{ 1 })) };
+    }
+
+    // Swap neighbours now and then and delay a few samples by up to 3 ms.
+    std::vector<OscillatorSample> arrivals = ordered;
+    uint32_t seed = 17;
+    for (int i = 0; i + 4 < samples; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        if ((seed >> 28) == 0) {
+            std::swap(arrivals[i], arrivals[i + 1]);
+            i += 3;
+        } else if ((seed >> 28) == 1) {
+            std::rotate(arrivals.begin() + i, arrivals.begin() + i + 1, arrivals.begin() + i + 4);
+            i += 3;
+        }
+    }
+    ASSERT_FALSE(std::is_sorted(arrivals.begin(), arrivals.end(), [](auto& a, auto& b) { return a.timestamp < b.timestamp; }));
+
+    OscillatorDetector reference;
+    std::vector<uint8_t> expected;
+    for (const auto& sample : ordered) {
+        expected.push_back(reference.update(sample.position, sample.direction, sample.timestamp));
+    }
+
+    OscillatorDetector detector;
+    OscillatorReorderBuffer<8> buffer(3000000);
+    std::vector<uint8_t> events;
+    int64_t last = std::numeric_limits<int64_t>::min();
+    auto sink = [&](const OscillatorSample& sample) {
+        EXPECT_GE(sample.timestamp, last);
+        last = sample.timestamp;
+        events.push_back(detector.update(sample.position, sample.direction, sample.timestamp));
+    };
+    for (const auto& sample : arrivals) {
+        EXPECT_TRUE(buffer.push(sample, sink));
+        EXPECT_LE(buffer.size(), 4u);
+    }
+    buffer.flush(sink);
+    EXPECT_EQ(buffer.size(), 0u);
+    EXPECT_EQ(buffer.getDropped(), 0u);
+    EXPECT_EQ(events, expected);
+
+    // A sample behind the watermark can no longer be ordered.
+    EXPECT_FALSE(buffer.push({ last - 1, 0, 0 }, sink));
+    EXPECT_EQ(buffer.getDropped(), 1u);
+
+    // A full ring releases its oldest sample early.
+    OscillatorReorderBuffer<4> small(1000000000);
+    std::vector<int64_t> released;
+    auto collect = [&](const OscillatorSample& sample) { released.push_back(sample.timestamp); };
+    for (int64_t t : { 5, 3, 4, 1, 2, 0, 6 }) {
+        small.push({ t, 0, 0 }, collect); // 2 pushes 1 out, so 0 is too late
+    }
+    small.flush(collect);
+    EXPECT_EQ(released, (std::vector<int64_t>{ 1, 2, 3, 4, 5, 6 }));
+    EXPECT_EQ(small.getDropped(), 1u);
+}
+
+TEST(OscillatorReorderBufferTest, TimestampsNearTheLimits) {
+    // The watermark saturates instead of overflowing at both ends of the range.
+    const int64_t lowest = std::numeric_limits<int64_t>::min();
+    const int64_t highest = std::numeric_limits<int64_t>::max();
+    std::vector<int64_t> released;
+    auto sink = [&](const OscillatorSample& sample) { released.push_back(sample.timestamp); };
+
+    OscillatorReorderBuffer<8> early(1000);
+    EXPECT_TRUE(early.push({ lowest + 10, 0, 0 }, sink));
+    EXPECT_TRUE(early.push({ lowest + 5, 0, 0 }, sink));
+    EXPECT_EQ(early.getWatermark(), lowest);
+    EXPECT_TRUE(released.empty());
+    early.flush(sink);
+    EXPECT_EQ(released, (std::vector<int64_t>{ lowest + 5, lowest + 10 }));
+
+    released.clear();
+    OscillatorReorderBuffer<8> ahead(-1000);    // releases immediately, at the latest + 1000
+    EXPECT_TRUE(ahead.push({ highest - 10, 0, 0 }, sink));
+    EXPECT_EQ(ahead.getWatermark(), highest);
+    EXPECT_EQ(released, (std::vector<int64_t>{ highest - 10 }));
+}
+
+TEST(OscillatorDetectorTest, SeverityLevelsShareOneCount) {
+    OscillatorDetector tiered;
+    tiered.setSeverityLevels({ 3, 8, 255, 255 });
+    OscillatorDetector warning;
+    warning.setSensitivity(3);
+    OscillatorDetector critical;
+    critical.setSensitivity(8);
+    OscillatorDetectorBank bank(1);
+    bank.setSeverityLevels({ 3, 8, 255, 255 });
+
+    int reached[3] = {};
+    for (int i = 0; i < 2000; ++i) {
+        double amplitude = i < 1000 ? 1000.0 : 0.0;
+        int64_t position = static_cast<int64_t>(amplitude * std::sin(DEG2RAD(i * 4)));
+        int8_t direction = static_cast<int8_t>(i < 1000 ? (std::cos(DEG2RAD(i * 4)) > 0 ? 1 : -1) : 0);
+
+        uint8_t mask = tiered.detectSeverity(position, direction);
+        EXPECT_EQ((mask & 1) != 0, warning.detect(position, direction)) << "sample " << i;
+        EXPECT_EQ((mask & 2) != 0, critical.detect(position, direction)) << "sample " << i;
+        EXPECT_EQ(mask & ~3, 0);
+        bank.update(&position, &direction, nullptr);
+        uint8_t banked = 0;
+        bank.computeSeverities(&banked);
+        EXPECT_EQ(banked, mask);
+        ++reached[std::bit_width(mask)];
+    }
+    EXPECT_GT(reached[1], 0);
+    EXPECT_GT(reached[2], 0);
+}
+
+TEST(OscillatorDetectorTest, ExitDelayStopsChatter) {
+    OscillatorDetector plain;
+    OscillatorDetector latched;
+    latched.setExitDelay(900);
+    OscillatorDetectorBank bank(3);
+    bank.setExitDelay(900);
+
+    int plainFlips = 0;
+    int latchedFlips = 0;
+    bool plainLast = false;
+    bool latchedLast = false;
+    int64_t prev = 0;
+    uint32_t seed = 1;
+    for (int i = 0; i < 20000; ++i) {
+        // Marginal oscillation: the noise keeps resetting the count.
+        seed = seed * 1664525u + 1013904223u;
+        double noise = static_cast<double>((seed >> 16) % 41) - 20.0;
+        int64_t position = static_cast<int64_t>(100.0 * std::sin(DEG2RAD(i * 2)) + noise);
+        int8_t direction = static_cast<int8_t>(std::clamp(position - prev, int64_t{ -1 }, int64_t{ 1 }));
+        prev = position;
+
+        bool p = plain.detect(position, direction);
+        bool l = latched.detect(position, direction);
+        plainFlips += p != plainLast;
+        latchedFlips += l != latchedLast;
+        plainLast = p;
+        latchedLast = l;
+        ASSERT_TRUE(!p || l) << "sample " << i; // hysteresis only extends detections
+
+        const int64_t positions[3] = { position, position, position };
+        const int8_t directions[3] = { direction, direction, direction };
+        uint8_t events[3];
+        bank.update(positions, directions, events);
+        ASSERT_EQ((events[2] & OscillatorEvent::Detected) != 0, l) << "sample " << i;
+    }
+    EXPECT_GT(plainFlips, 40);
+    EXPECT_LT(latchedFlips * 3, plainFlips);
+}
+
+TEST(OscillatorHistoryTest, KeepsLastExtremaAndResets) {
+    OscillatorDetector detector;
+    OscillatorHistory<16> history;
+    std::vector<OscillatorHistoryEntry> all;
+    int64_t prev = 0;
+    uint32_t seed = 1;
+
+    for (int i = 0; i < 3600; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        double noise = static_cast<double>((seed >> 16) % 41) - 20.0; // makes the count reset now and then
+        int64_t position = static_cast<int64_t>(1000.0 * std::sin(DEG2RAD(i)) + noise);
+        int direction = static_cast<int>(std::clamp(position - prev, int64_t{ -1 }, int64_t{ 1 }));
+        prev = position;
+
+        uint8_t events = detector.update(position, direction);
+        history.record(i, position, events);
+        if (events & OscillatorEvent::Extremum) {
+            bool maximum = (events & OscillatorEvent::Maximum) != 0;
+            all.push_back({ i, position, maximum ? OscillatorHistoryKind::Maximum : OscillatorHistoryKind::Minimum });
+        }
+        if (events & OscillatorEvent::Reset) {
+            all.push_back({ i, position, OscillatorHistoryKind::Reset });
+        }
+        EXPECT_TRUE(!(events & OscillatorEvent::Maximum) || (events & OscillatorEvent::Extremum));
+    }
+
+    ASSERT_GT(all.size(), 16u);
+    EXPECT_TRUE(std::any_of(all.begin(), all.end(), [](auto& e) { return e.kind == OscillatorHistoryKind::Reset; }));
+    EXPECT_EQ(history.getTotal(), all.size());
+    ASSERT_EQ(history.size(), 16u);
+    std::vector<OscillatorHistoryEntry> held(16);
+    EXPECT_EQ(history.copy(held.data()), 16u);
+    for (std::size_t i = 0; i < 16; ++i) {
+        const auto& expected = all[all.size() - 16 + i];
+        EXPECT_EQ(held[i].sample, expected.sample);
+        EXPECT_EQ(held[i].position, expected.position);
+        EXPECT_EQ(held[i].kind, expected.kind);
+        EXPECT_EQ(history[i].sample, expected.sample);
+    }
+
+    history.reset();
+    EXPECT_EQ(history.size(), 0u);
+}
+
+TEST(OscillatorDetectorTest, DerivedModesFindOscillationInVelocity) {
+    // A ramp whose slope wobbles: the position only rises, but its velocity oscillates.
+    const std::size_t channels = 19;
+    OscillatorDetectorBank bank(channels);
+    bank.setDerivative(OscillatorDerivative::Velocity, 2);
+    std::vector<OscillatorDetector> detectors(channels);
+    for (std::size_t c = 0; c < channels; ++c) {
+        detectors[c].setDerivative(c % 2 ? OscillatorDerivative::Velocity : OscillatorDerivative::Acceleration, 2);
+    }
+    OscillatorDetectorBank accelerations(channels);
+    accelerations.setDerivative(OscillatorDerivative::Acceleration, 2);
+    OscillatorDetector plain;
+
+    std::vector<int64_t> positions(channels);
+    std::vector<uint8_t> velocityEvents(channels);
+    std::vector<uint8_t> accelerationEvents(channels);
+    std::vector<double> phase(channels, 0.0);
+    int64_t prev = 0;
+    int plainDetections = 0;
+    int derivedDetections = 0;
+    for (int i = 0; i < 3000; ++i) {
+        for (std::size_t c = 0; c < channels; ++c) {
+            phase[c] += 50.0 + 40.0 * std::sin(DEG2RAD(i * (3 + c % 4)));
+            positions[c] = static_cast<int64_t>(phase[c]);
+        }
+        bank.update(positions.data(), nullptr, velocityEvents.data());
+        accelerations.update(positions.data(), nullptr, accelerationEvents.data());
+        for (std::size_t c = 0; c < channels; ++c) {
+            uint8_t flags = detectors[c].update(positions[c], 0);
+            ASSERT_EQ(flags, c % 2 ? velocityEvents[c] : accelerationEvents[c]) << "channel " << c << " sample " << i;
+            derivedDetections += (flags & OscillatorEvent::Detected) != 0;
+        }
+        plainDetections += plain.detect(positions[0], static_cast<int>(std::clamp(positions[0] - prev, int64_t{ -1 }, int64_t{ 1 })));
+        prev = positions[0];
+    }
+    EXPECT_EQ(plainDetections, 0);
+    EXPECT_GT(derivedDetections, 3000 * static_cast<int>(channels) / 2);
+}
+
+TEST(OscillatorDetectorTest, DerivativeSmoothingIsClamped) {
+    // Shifts of 64 or more would be undefined; the setters clamp to 62.
+    OscillatorDetector detector;
+    detector.setDerivative(OscillatorDerivative::Acceleration, 200);
+    EXPECT_EQ(detector.getDerivativeSmoothing(), 62);
+    OscillatorDetectorBank bank(3);
+    bank.setDerivative(OscillatorDerivative::Velocity, 64);
+    EXPECT_EQ(bank.getDerivativeSmoothing(), 62);
+    std::vector<int64_t> positions(3);
+    std::vector<uint8_t> events(3);
+    for (int i = 0; i < 50; ++i) {
+        const int64_t position = (i % 5) - 2;
+        detector.update(position, 0);
+        std::fill(positions.begin(), positions.end(), position);
+        bank.update(positions.data(), nullptr, events.data());
+    }
+}
+
+TEST(PlanarOscillatorDetectorTest, FindsOscillationAlongAnyAxis) {
+    const std::size_t channels = 12;
+    PlanarOscillatorDetectorBank bank(channels);
+    std::vector<PlanarOscillatorDetector> detectors(channels);
+    OscillatorDetector axisX;
+
+    std::vector<int64_t> xs(channels);
+    std::vector<int64_t> ys(channels);
+    std::vector<uint8_t> events(channels);
+    std::vector<int> detections(channels, 0);
+    std::vector<int> lateDetections(channels, 0);
+    int axisXDetections = 0;
+    int64_t prevX = 0;
+
+    for (int i = 0; i < 2000; ++i) {
+        for (std::size_t c = 0; c < channels; ++c) {
+            // Motion along 90 + 15 * c degrees around an offset centre, turning by 45 degrees halfway.
+            double swing = 800.0 * std::sin(DEG2RAD(i * 6));
+            double angle = DEG2RAD(15.0 * c + 90.0 + (i >= 1000 ? 45.0 : 0.0));
+            xs[c] = 100000 + static_cast<int64_t>(swing * std::cos(angle));
+            ys[c] = -50000 + static_cast<int64_t>(swing * std::sin(angle));
+        }
+        bank.update(xs.data(), ys.data(), events.data());
+        for (std::size_t c = 0; c < channels; ++c) {
+            uint8_t flags = detectors[c].update(xs[c], ys[c]);
+            ASSERT_EQ(events[c], flags) << "channel " << c << " sample " << i;
+            detections[c] += (flags & OscillatorEvent::Detected) != 0;
+            lateDetections[c] += i >= 1500 && (flags & OscillatorEvent::Detected) != 0;
+        }
+        if (i < 1000) {
+            axisXDetections += axisX.detect(xs[0], static_cast<int>(std::clamp(xs[0] - prevX, int64_t{ -1 }, int64_t{ 1 })));
+        }
+        prevX = xs[0];
+    }
+
+    EXPECT_EQ(axisXDetections, 0); // channel 0 moves along y only before the turn
+    for (std::size_t c = 0; c < channels; ++c) {
+        EXPECT_GT(detections[c], 1500) << "channel " << c;
+        EXPECT_EQ(lateDetections[c], 500) << "channel " << c;
+        float expected = static_cast<float>(15.0 * c + 135.0);
+        float error = std::fmod(std::fabs(detectors[c].getAxisAngle() - expected), 180.0f);
+        EXPECT_LT(std::min(error, 180.0f - error), 1.0f) << "channel " << c;
+        EXPECT_EQ(bank.getState(c).latchX, detectors[c].getState().latchX) << "channel " << c;
+    }
+}
+
+TEST(PlanarOscillatorDetectorTest, BankMatchesDetectorsAtAnyAmplitude) {
+    // Amplitudes from 2^8 to 2^30 exercise both directions of the covariance
+    // normalization and the reciprocal rescale; the axis keeps turning so the
+    // channels re-latch.
+    const std::size_t channels = 12;
+    PlanarOscillatorDetectorBank bank(channels);
+    std::vector<PlanarOscillatorDetector> detectors(channels);
+
+    std::vector<int64_t> xs(channels);
+    std::vector<int64_t> ys(channels);
+    std::vector<uint8_t> events(channels);
+    int detections = 0;
+    for (int i = 0; i < 3000; ++i) {
+        for (std::size_t c = 0; c < channels; ++c) {
+            double swing = std::ldexp(std::sin(DEG2RAD(i * 7)), 8 + 2 * static_cast<int>(c));
+            double angle = DEG2RAD(20.0 * c + 0.05 * i);
+            xs[c] = 1000000000 + static_cast<int64_t>(swing * std::cos(angle));
+            ys[c] = -300000000 + static_cast<int64_t>(swing * std::sin(angle));
+        }
+        bank.update(xs.data(), ys.data(), events.data());
+        for (std::size_t c = 0; c < channels; ++c) {
+            uint8_t flags = detectors[c].update(xs[c], ys[c]);
+            ASSERT_EQ(events[c], flags) << "channel " << c << " sample " << i;
+            detections += (flags & OscillatorEvent::Detected) != 0;
+        }
+    }
+
+    EXPECT_GT(detections, 0);
+    for (std::size_t c = 0; c < channels; ++c) {
+        PlanarOscillatorState expected = detectors[c].getState();
+        PlanarOscillatorState actual = bank.getState(c);
+        EXPECT_EQ(actual.covarianceXX, expected.covarianceXX) << "channel " << c;
+        EXPECT_EQ(actual.covarianceXY, expected.covarianceXY) << "channel " << c;
+        EXPECT_EQ(actual.axisX, expected.axisX) << "channel " << c;
+        EXPECT_EQ(actual.axisY, expected.axisY) << "channel " << c;
+        EXPECT_EQ(actual.latchX, expected.latchX) << "channel " << c;
+        EXPECT_EQ(actual.latchY, expected.latchY) << "channel " << c;
+        EXPECT_EQ(actual.offset, expected.offset) << "channel " << c;
+        EXPECT_NE(actual.offset, 0) << "channel " << c;
+    }
+}
+
+TEST(OscillatorDetectorBankTest, ErrorUpdateMatchesStandaloneDetectors) {
+    // A ramping setpoint; the feedback rings around it on two of every three channels.
+    const std::size_t channels = 37;
+    OscillatorDetectorBank bank(channels);
+    std::vector<OscillatorDetector> detectors(channels);
+    OscillatorDetectorBank feedbackBank(channels);
+
+    std::vector<int64_t> setpoints(channels);
+    std::vector<int64_t> feedbacks(channels);
+    std::vector<int64_t> lastErrors(channels, 0);
+    std::vector<int8_t> feedbackDirections(channels, 0);
+    std::vector<uint8_t> events(channels);
+    std::vector<uint8_t> feedbackEvents(channels);
+    int errorDetections = 0;
+    int feedbackDetections = 0;
+    for (int i = 0; i < 2000; ++i) {
+        for (std::size_t c = 0; c < channels; ++c) {
+            double ringing = c % 3 ? 400.0 * std::sin(DEG2RAD(i * (4 + c % 5))) : 0.0;
+            setpoints[c] = 1000 * i + static_cast<int64_t>(c);
+            feedbacks[c] = setpoints[c] - 300 - static_cast<int64_t>(ringing);
+            feedbackDirections[c] = i > 0 ? 1 : 0;
+        }
+        bank.updateError(setpoints.data(), feedbacks.data(), events.data());
+        feedbackBank.update(feedbacks.data(), feedbackDirections.data(), feedbackEvents.data());
+        for (std::size_t c = 0; c < channels; ++c) {
+            int64_t error = setpoints[c] - feedbacks[c];
+            int direction = i > 0 ? (error > lastErrors[c]) - (error < lastErrors[c]) : 0;
+            lastErrors[c] = error;
+            uint8_t flags = detectors[c].update(error, direction);
+            ASSERT_EQ(events[c], flags) << "channel " << c << " sample " << i;
+            errorDetections += (flags & OscillatorEvent::Detected) != 0;
+            feedbackDetections += (feedbackEvents[c] & OscillatorEvent::Detected) != 0;
+            if (c % 3 == 0) {
+                EXPECT_EQ(flags & OscillatorEvent::Detected, 0) << "channel " << c << " sample " << i;
+            }
+        }
+    }
+    EXPECT_EQ(feedbackDetections, 0);
+    EXPECT_GT(errorDetections, 2000 * 24 * 3 / 4);
+}
+
+TEST(OscillatorDetectorTest, HalfPeriodBandSelectsFrequencies) {
+    // Half periods of 5, 30 and 180 samples; only 30 lies in the band [15, 60].
+    const int steps[] = { 36, 6, 1 };
+    const std::size_t channels = 3;
+    OscillatorDetectorBank bank(channels);
+    bank.setHalfPeriodBand(15, 60);
+    std::vector<OscillatorDetector> gated(channels);
+    std::vector<OscillatorDetector> plain(channels);
+    for (auto& detector : gated) {
+        detector.setHalfPeriodBand(15, 60);
+    }
+
+    std::vector<int64_t> positions(channels);
+    std::vector<int8_t> directions(channels);
+    std::vector<int64_t> prev(channels, 0);
+    std::vector<uint8_t> events(channels);
+    std::vector<int> gatedDetections(channels, 0);
+    std::vector<int> plainDetections(channels, 0);
+    for (int i = 0; i < 2000; ++i) {
+        for (std::size_t c = 0; c < channels; ++c) {
+            positions[c] = static_cast<int64_t>(1000.0 * std::sin(DEG2RAD(i * steps[c])));
+            directions[c] = static_cast<int8_t>(std::clamp(positions[c] - prev[c], int64_t{ -1 }, int64_t{ 1 }));
+            prev[c] = positions[c];
+        }
+        bank.update(positions.data(), directions.data(), events.data());
+        for (std::size_t c = 0; c < channels; ++c) {
+            uint8_t flags = gated[c].update(positions[c], directions[c]);
+            ASSERT_EQ(events[c], flags) << "channel " << c << " sample " << i;
+            gatedDetections[c] += (flags & OscillatorEvent::Detected) != 0;
+            plainDetections[c] += plain[c].detect(positions[c], directions[c]);
+        }
+    }
+    for (std::size_t c = 0; c < channels; ++c) {
+        EXPECT_GT(plainDetections[c], 0) << "channel " << c;
+    }
+    EXPECT_EQ(gatedDetections[0], 0);
+    EXPECT_EQ(gatedDetections[1], plainDetections[1]);
+    EXPECT_EQ(gatedDetections[2], 0);
+}
+
+TEST(OscillatorDetectorTest, DefaultBandCountsAfterLongPause) {
+    // Up 10, down 20, up 30, a pause longer than the saturating spacing counter,
+    // then a growing oscillation. The default band must not drop any extremum.
+    auto run = [](int pause) {
+        OscillatorDetector detector;
+        int64_t position = 0;
+        int detections = 0;
+        auto feed = [&](int samples, int direction) {
+            for (int i = 0; i < samples; ++i) {
+                position += direction;
+                detections += detector.detect(position, direction);
+            }
+        };
+        feed(10, 1);
+        feed(20, -1);
+        feed(30, 1);
+        feed(pause, 0);
+        detections = 0;
+        for (int i = 0; i < 50; ++i) {
+            feed(40 + 4 * i, -1);
+            feed(42 + 4 * i, 1);
+        }
+        return detections;
+    };
+    const int shortPause = run(1000);
+    EXPECT_GT(shortPause, 0);
+    EXPECT_EQ(run(70000), shortPause);
+}
+
+TEST(OscillatorDetectorBankTest, IncrementalCheckpointsRestoreTheBank) {
+    const std::size_t channels = 300;
+    OscillatorDetectorBank bank(channels);
+    bank.setDerivative(OscillatorDerivative::Velocity, 1);
+    std::vector<OscillatorChannelRecord> base;
+    bank.snapshot(base);
+    EXPECT_EQ(base.size(), channels);
+    EXPECT_EQ(bank.dirtyCount(), 0u);
+
+    std::vector<uint32_t> reporting;
+    std::vector<int64_t> positions, timestamps;
+    std::vector<uint8_t> events(channels);
+    std::vector<OscillatorChannelRecord> delta;
+    uint32_t seed = 5;
+    int64_t now = 0;
+    for (int i = 0; i < 2000; ++i) {
+        now += 1000000;
+        reporting.clear(), positions.clear(), timestamps.clear();
+        std::vector<bool> touched(channels, false);
+        for (uint32_t c = 0; c < channels; c += 1 + (seed >> 29)) { // a sparse, varying subset
+            seed = seed * 1664525u + 1013904223u;
+            if (c % 10 < 8 || touched[c]) {
+                continue;
+            }
+            touched[c] = true;
+            reporting.push_back(c);
+            positions.push_back(i * 100 + static_cast<int64_t>(50.0 * std::sin(DEG2RAD(i * 7 + c))));
+            timestamps.push_back(now);
+        }
+        bank.update(reporting.data(), reporting.size(), positions.data(), nullptr, timestamps.data(), events.data());
+        if (i % 100 == 99) {
+            // Only the channels that reported are written, then folded into the base.
+            delta.clear();
+            EXPECT_LE(bank.checkpoint(delta), channels / 5);
+            OscillatorDetectorBank::compact(base, delta.data(), delta.size());
+        }
+    }
+    delta.clear();
+    bank.checkpoint(delta);
+    OscillatorDetectorBank::compact(base, delta.data(), delta.size());
+
+    OscillatorDetectorBank restored(channels);
+    restored.setDerivative(OscillatorDerivative::Velocity, 1);
+    restored.restore(base.data(), base.size(), bank.getClock());
+    std::vector<uint8_t> restoredEvents(channels);
+    std::vector<int64_t> frame(channels);
+    std::vector<int64_t> frameTimes(channels, now + 1000000);
+    for (std::size_t c = 0; c < channels; ++c) {
+        EXPECT_EQ(restored.getState(c).extremaCounter, bank.getState(c).extremaCounter) << "channel " << c;
+        EXPECT_EQ(restored.getState(c).maxFoundPos, bank.getState(c).maxFoundPos) << "channel " << c;
+        frame[c] = 200000 + static_cast<int64_t>(c);
+    }
+    bank.update(frame.data(), nullptr, frameTimes.data(), events.data());
+    restored.update(frame.data(), nullptr, frameTimes.data(), restoredEvents.data());
+    EXPECT_EQ(events, restoredEvents);
+    EXPECT_EQ(bank.dirtyCount(), channels); // the first dense update moves every sample time to a new base
+}
+
+TEST(OscillatorDetectorBankTest, QuietChannelsStayOutOfCheckpoints) {
+    // Per channel group: oscillating, ramping, constant, oscillating and then quiet.
+    const std::size_t channels = 40;
+    OscillatorDetectorBank bank(channels);
+    bank.setHoldOff(30);
+    std::vector<OscillatorDetector> detectors(channels);
+    for (OscillatorDetector& detector : detectors) {
+        detector.setHoldOff(30);
+    }
+    std::vector<OscillatorChannelRecord> base;
+    std::vector<OscillatorChannelRecord> delta;
+    bank.snapshot(base);
+    uint32_t clock = bank.getClock();
+
+    std::vector<int64_t> positions(channels);
+    std::vector<int8_t> directions(channels);
+    std::vector<uint8_t> events(channels);
+    std::vector<int64_t> previous(channels, 0);
+    auto tick = [&](int i) {
+        for (std::size_t c = 0; c < channels; ++c) {
+            const bool oscillating = c % 4 == 0 || (c % 4 == 3 && i < 1000);
+            const int64_t position = oscillating ? static_cast<int64_t>(100.0 * std::sin(DEG2RAD(i * 20 + c)))
+                                   : c % 4 == 1 ? i : previous[c];
+            positions[c] = position;
+            directions[c] = static_cast<int8_t>(i == 0 ? 0 : (position > previous[c]) - (position < previous[c]));
+            previous[c] = position;
+        }
+        bank.update(positions.data(), directions.data(), events.data());
+        for (std::size_t c = 0; c < channels; ++c) {
+            ASSERT_EQ(events[c], detectors[c].update(positions[c], directions[c])) << "channel " << c << " sample " << i;
+        }
+    };
+    for (int i = 0; i < 72000; ++i) {
+        tick(i);
+        if (i % 500 == 499) {
+            delta.clear();
+            const std::size_t written = bank.checkpoint(delta);
+            OscillatorDetectorBank::compact(base, delta.data(), delta.size());
+            clock = bank.getClock();
+            if (i >= 2000) {
+                EXPECT_EQ(written, channels / 4) << "sample " << i;   // only the channels that still oscillate
+            }
+        }
+    }
+
+    // The records of the quiet channels are old, but their counters, saturated
+    // ones included, follow the clock saved with the last checkpoint.
+    OscillatorDetectorBank restored(channels);
+    restored.setHoldOff(30);
+    restored.restore(base.data(), base.size(), clock);
+    for (std::size_t c = 0; c < channels; ++c) {
+        const OscillatorDetectorState expected = detectors[c].getState();
+        for (const OscillatorDetectorBank* source : { &bank, &restored }) {
+            const OscillatorDetectorState state = source->getState(c);
+            EXPECT_EQ(state.samplesSinceExtremum, expected.samplesSinceExtremum) << "channel " << c;
+            EXPECT_EQ(state.envelope.samplesSinceTurn, expected.envelope.samplesSinceTurn) << "channel " << c;
+            EXPECT_EQ(state.holdOffCounter, expected.holdOffCounter) << "channel " << c;
+            EXPECT_EQ(state.extremaCounter, expected.extremaCounter) << "channel " << c;
+            EXPECT_EQ(state.flipRate, expected.flipRate) << "channel " << c;
+        }
+    }
+    EXPECT_EQ(bank.getState(2).samplesSinceExtremum, 65535);
+    std::vector<uint8_t> restoredEvents(channels);
+    for (int i = 72000; i < 72100; ++i) {
+        tick(i);
+        std::vector<uint8_t> bankEvents = events;
+        restored.update(positions.data(), directions.data(), restoredEvents.data());
+        ASSERT_EQ(restoredEvents, bankEvents) << "sample " << i;
+    }
+}
+
+TEST(OscillatorDetectorBankTest, TimedQuietChannelsStayOutOfCheckpoints) {
+    // Every channel takes a new sample time on each tick, but a channel with a
+    // constant input must still stay out of the checkpoints.
+    const std::size_t channels = 1024;
+    OscillatorDetectorBank bank(channels);
+    bank.setStaleAfter(20 * 1000000);
+    EXPECT_EQ(bank.dirtyCount(), channels); // nothing tracked before the first snapshot
+
+    std::vector<int64_t> positions(channels);
+    std::vector<int8_t> directions(channels);
+    std::vector<int64_t> timestamps(channels);
+    std::vector<uint8_t> events(channels);
+    std::vector<int64_t> previous(channels, 0);
+    int64_t now = 5000000000;
+    auto tick = [&](OscillatorDetectorBank& target, int i) {
+        for (std::size_t c = 0; c < channels; ++c) {
+            const int64_t position = c % 8 == 0 ? static_cast<int64_t>(100.0 * std::sin(DEG2RAD(i * 20 + c))) : int64_t(c);
+            directions[c] = static_cast<int8_t>((position > previous[c]) - (position < previous[c]));
+            positions[c] = position;
+            timestamps[c] = now;
+        }
+        return target.update(positions.data(), directions.data(), timestamps.data(), events.data());
+    };
+    auto advance = [&](int i) {
+        now += 1000000 + (i % 5) * 300000; // a common but irregular tick
+        tick(bank, i);
+        previous = positions;
+    };
+    for (int i = 0; i < 100; ++i) {
+        advance(i);
+    }
+    std::vector<OscillatorChannelRecord> base;
+    std::vector<OscillatorChannelRecord> delta;
+    bank.snapshot(base);
+    for (int i = 100; i < 600; ++i) {
+        advance(i);
+        if (i % 100 == 99) {
+            delta.clear();
+            EXPECT_EQ(bank.checkpoint(delta), channels / 8) << "sample " << i; // only the oscillating channels
+            OscillatorDetectorBank::compact(base, delta.data(), delta.size());
+        }
+    }
+
+    // The records of the constant channels are 500 ticks old; restored against
+    // the saved time base they are not stale.
+    OscillatorDetectorBank restored(channels);
+    restored.setStaleAfter(20 * 1000000);
+    restored.restore(base.data(), base.size(), bank.getClock(), bank.getTimeBase());
+    EXPECT_EQ(restored.expire(now), 0u);
+    EXPECT_EQ(bank.expire(now), 0u);
+    std::vector<uint8_t> restoredEvents(channels);
+    for (int i = 600; i < 700; ++i) {
+        now += 1000000;
+        tick(restored, i);
+        restoredEvents = events;
+        tick(bank, i);
+        previous = positions;
+        ASSERT_EQ(restoredEvents, events) << "sample " << i;
+    }
+    for (std::size_t c = 0; c < channels; ++c) {
+        EXPECT_EQ(restored.getState(c).extremaCounter, bank.getState(c).extremaCounter) << "channel " << c;
+    }
+}
+
+TEST(OscillatorDetectorBankTest, CopyRunsWhatIfWithoutDisturbingLiveBank) {
+    const std::size_t channels = 5000;
+    OscillatorDetectorBank live(channels);
+    std::vector<uint32_t> reporting;
+    std::vector<int64_t> positions, timestamps;
+    std::vector<int8_t> directions;
+    auto frame = [&](int i) {
+        // Only the first 400 channels report.
+        reporting.clear(), positions.clear(), directions.clear(), timestamps.clear();
+        for (uint32_t c = 0; c < 400; ++c) {
+            double now = 300.0 * std::sin(DEG2RAD(i * (2 + c % 7)));
+            double before = 300.0 * std::sin(DEG2RAD((i - 1) * (2 + c % 7)));
+            reporting.push_back(c);
+            positions.push_back(static_cast<int64_t>(now));
+            directions.push_back(static_cast<int8_t>((now > before) - (now < before)));
+            timestamps.push_back(int64_t{ i } * 1000000);
+        }
+    };
+    std::vector<uint8_t> liveEvents(400), copyEvents(400), referenceEvents(400), whatIfEvents(400);
+    for (int i = 0; i < 100; ++i) {
+        frame(i);
+        live.update(reporting.data(), reporting.size(), positions.data(), directions.data(), timestamps.data(), liveEvents.data());
+    }
+
+    // References built the slow way, from a full snapshot.
+    std::vector<OscillatorChannelRecord> records;
+    live.snapshot(records);
+    OscillatorDetectorBank reference(channels);
+    reference.restore(records.data(), records.size(), live.getClock());
+    OscillatorDetectorBank whatIf(channels);
+    whatIf.restore(records.data(), records.size(), live.getClock());
+    whatIf.setSensitivity(3);
+
+    OscillatorDetectorBank copy = live;
+    copy.setSensitivity(3);
+
+    int differences = 0;
+    for (int i = 100; i < 400; ++i) {
+        frame(i);
+        live.update(reporting.data(), reporting.size(), positions.data(), directions.data(), timestamps.data(), liveEvents.data());
+        copy.update(reporting.data(), reporting.size(), positions.data(), directions.data(), timestamps.data(), copyEvents.data());
+        reference.update(reporting.data(), reporting.size(), positions.data(), directions.data(), timestamps.data(), referenceEvents.data());
+        whatIf.update(reporting.data(), reporting.size(), positions.data(), directions.data(), timestamps.data(), whatIfEvents.data());
+        ASSERT_EQ(liveEvents, referenceEvents) << "sample " << i;
+        ASSERT_EQ(copyEvents, whatIfEvents) << "sample " << i;
+        differences += liveEvents != copyEvents;
+    }
+    EXPECT_GT(differences, 0);
+    EXPECT_EQ(copy.getSensitivity(), 3);
+    EXPECT_EQ(live.getSensitivity(), 5);
+}
+
+TEST(OscillatorReplayTest, SeekRestoresEveryPastState) {
+    OscillatorDetector configured;
+    configured.setExitDelay(50);
+    OscillatorReplay replay(configured, 256);
+    OscillatorDetector reference = configured;
+    std::vector<OscillatorDetectorState> states{ reference.getState() };
+
+    uint32_t seed = 7;
+    int64_t prev = 0;
+    for (int i = 0; i < 5000; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        double amplitude = (i / 700) % 2 ? 600.0 : 40.0;
+        int64_t position = static_cast<int64_t>(amplitude * std::sin(DEG2RAD(i * 5))) + (seed >> 27);
+        int direction = static_cast<int>(std::clamp(position - prev, int64_t{ -1 }, int64_t{ 1 }));
+        prev = position;
+        ASSERT_EQ(replay.record(position, direction), reference.update(position, direction));
+        states.push_back(reference.getState());
+    }
+    ASSERT_EQ(replay.size(), 5000u);
+
+    // Random jumps back and forth, then a forward walk that continues from the cursor.
+    std::vector<std::size_t> targets{ 5000, 0, 4097, 255, 256, 257, 1300, 1299, 3333 };
+    for (std::size_t sample = 2000; sample < 2600; sample += 7) {
+        targets.push_back(sample);
+    }
+    for (std::size_t sample : targets) {
+        const OscillatorDetectorState& state = replay.seek(sample).getState();
+        const OscillatorDetectorState& expected = states[sample];
+        EXPECT_EQ(state.extremaCounter, expected.extremaCounter) << "sample " << sample;
+        EXPECT_EQ(state.lastDirection, expected.lastDirection) << "sample " << sample;
+        EXPECT_EQ(state.minFoundPos, expected.minFoundPos) << "sample " << sample;
+        EXPECT_EQ(state.maxFoundPos, expected.maxFoundPos) << "sample " << sample;
+        EXPECT_EQ(state.maximumDebounceCounter, expected.maximumDebounceCounter) << "sample " << sample;
+        EXPECT_EQ(state.exitCountdown, expected.exitCountdown) << "sample " << sample;
+        EXPECT_EQ(state.halfPeriod, expected.halfPeriod) << "sample " << sample;
+        EXPECT_EQ(state.envelope.swing, expected.envelope.swing) << "sample " << sample;
+        EXPECT_EQ(state.flipRate, expected.flipRate) << "sample " << sample;
+    }
+    EXPECT_EQ(replay.seek(5000).getState().extremaCounter, replay.getLive().getState().extremaCounter);
+}
+
+TEST(OscillatorReplayTest, TimedTraceKeepsItsForm) {
+    OscillatorDetector configured;
+    configured.setSmootherTime(3000);
+    OscillatorReplay replay(configured, 64);
+    OscillatorDetector reference = configured;
+    std::vector<OscillatorDetectorState> states{ reference.getState() };
+
+    int64_t timestamp = 0;
+    int64_t prev = 0;
+    for (int i = 0; i < 400; ++i) {
+        timestamp += 500 + (i % 7) * 300;
+        int64_t position = static_cast<int64_t>(300.0 * std::sin(DEG2RAD(i * 9)));
+        int direction = static_cast<int>(std::clamp(position - prev, int64_t{ -1 }, int64_t{ 1 }));
+        prev = position;
+        ASSERT_EQ(replay.record(position, direction, timestamp), reference.update(position, direction, timestamp));
+        states.push_back(reference.getState());
+    }
+    for (std::size_t sample : { std::size_t{ 400 }, std::size_t{ 0 }, std::size_t{ 129 }, std::size_t{ 63 }, std::size_t{ 64 } }) {
+        EXPECT_EQ(replay.seek(sample).getState().extremaCounter, states[sample].extremaCounter) << "sample " << sample;
+        EXPECT_EQ(replay.seek(sample).getState().lastDirection, states[sample].lastDirection) << "sample " << sample;
+    }
+
+    // The first record() fixed the trace as timestamped; a count-based record is a usage error.
+    EXPECT_DEBUG_DEATH(replay.record(0, 1), "timestamp");
+    OscillatorReplay counted(configured, 64);
+    counted.record(0, 1);
+    EXPECT_DEBUG_DEATH(counted.record(1, 1, 1000), "timestamp");
+}
+
+TEST(OscillatorFlightRecorderTest, FreezesOnDetectionAndDumpsWindow) {
+    const std::size_t channels = 40;
+    OscillatorDetectorBank bank(channels);
+    OscillatorFlightRecorder recorder(channels, 50);
+    EXPECT_EQ(recorder.capacity(), 64u);
+
+    std::vector<int64_t> positions(channels, 0);
+    std::vector<int8_t> directions(channels, 0);
+    std::vector<uint8_t> events(channels);
+    std::vector<int64_t> history; // inputs of channel 7
+    std::size_t frozenAt = 0;
+    for (std::size_t i = 0; i < 1000; ++i) {
+        for (std::size_t c = 0; c < channels; ++c) {
+            int64_t position = c == 7 && i >= 300 ? static_cast<int64_t>(500.0 * std::sin(DEG2RAD(i * 10))) : int64_t(c);
+            directions[c] = static_cast<int8_t>(std::clamp(position - positions[c], int64_t{ -1 }, int64_t{ 1 }));
+            positions[c] = position;
+        }
+        history.push_back(positions[7]);
+        const uint8_t any = bank.update(positions.data(), directions.data(), events.data());
+        uint8_t expected = 0;
+        for (uint8_t flags : events) {
+            expected |= flags;
+        }
+        EXPECT_EQ(any, expected);
+        if (recorder.record(positions.data(), directions.data(), events.data(), any) && frozenAt == 0) {
+            frozenAt = i;
+        }
+    }
+    ASSERT_GT(frozenAt, 300u);
+    ASSERT_EQ(recorder.getAffected(), std::vector<uint32_t>{ 7 });
+    ASSERT_EQ(recorder.size(), 64u);
+    EXPECT_EQ(recorder.getPosition(0, 7), history[frozenAt]); // frames after the trigger were ignored
+    EXPECT_EQ(recorder.getPosition(0, 3), 3);
+
+    std::ostringstream out;
+    recorder.dump(out);
+    const std::string trace = out.str();
+    ASSERT_EQ(trace.size(), 24u + 4u + 64u * 9u);
+    EXPECT_EQ(trace.compare(0, 8, std::string("OSCFLT1\0", 8)), 0);
+    uint32_t channelCount = 0, frameCount = 0, channel = 0;
+    uint64_t first = 0;
+    std::memcpy(&channelCount, trace.data() + 8, 4);
+    std::memcpy(&frameCount, trace.data() + 12, 4);
+    std::memcpy(&first, trace.data() + 16, 8);
+    std::memcpy(&channel, trace.data() + 24, 4);
+    EXPECT_EQ(channelCount, 1u);
+    EXPECT_EQ(frameCount, 64u);
+    EXPECT_EQ(first, frozenAt + 1 - 64);
+    EXPECT_EQ(channel, 7u);
+    for (std::size_t frame = 0; frame < 64; ++frame) {
+        int64_t position = 0;
+        std::memcpy(&position, trace.data() + 28 + frame * 8, 8);
+        int64_t expected = history[first + frame];
+        EXPECT_EQ(position, expected) << "frame " << frame;
+        int8_t direction = trace[28 + 64 * 8 + frame];
+        EXPECT_EQ(direction, std::clamp(expected - history[first + frame - 1], int64_t{ -1 }, int64_t{ 1 })) << "frame " << frame;
+    }
+
+    // An external trigger with its own channel selection.
+    recorder.resume();
+    recorder.record(positions.data(), directions.data());
+    const uint32_t selected[] = { 0, 39 };
+    recorder.freeze(selected, 2);
+    std::ostringstream external;
+    recorder.dump(external);
+    EXPECT_EQ(external.str().size(), 24u + 2u * (4u + 64u * 9u));
+}